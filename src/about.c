@@ -26,6 +26,7 @@
 **
 ** History
 **	10-Jun-2017	Initial code
+**	19-Oct-2026	New version text set when the panel is built
 **
 */
 
@@ -177,14 +178,15 @@ GtkWidget * about_hdr(MainUi *m_ui)
 GtkWidget * about_nver(MainUi *m_ui)
 {  
     GtkWidget *nver_box;
-    char *s;
 
-    s = (char *) malloc(30);
-    sprintf(s, "   ");
-    m_ui->new_vers_info = gtk_label_new(s);
+    /* Any new version found before the panel was built */
+    if (m_ui->new_vers[0] != '\0')
+	m_ui->new_vers_info = gtk_label_new(m_ui->new_vers);
+    else
+	m_ui->new_vers_info = gtk_label_new("   ");
+
     gtk_widget_set_name(m_ui->new_vers_info, "title_5");
     gtk_widget_set_margin_start(GTK_WIDGET (m_ui->new_vers_info), 30);
-    free(s);
     gtk_widget_set_halign (m_ui->new_vers_info, GTK_ALIGN_END);
     gtk_widget_set_valign (m_ui->new_vers_info, GTK_ALIGN_END);
 
@@ -0,0 +1,337 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:
+**  Adaptive data refresh interval.
+**  The next refresh is set from the projected time until usage reaches the next quota
+**  threshold (80%, 90%, 100%) or the period rolls over. The usage velocity used is the
+**  highest of: the ISP total between refreshes, the local counters of the default route
+**  (ISP facing) interface, recent daily history (if loaded) and the average so far this period. Half the projected time is used
+**  so refreshes close in on a threshold. The result is kept within the min / max preferences.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Defines */
+
+#define HIST_DAYS 7
+#define PROC_NET_ROUTE "/proc/net/route"
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <net/if.h>
+#include <net/route.h>
+#include <gtk/gtk.h>
+#include <main.h>
+#include <isp.h>
+#include <net_stats.h>
+#include <defs.h>
+
+
+/* Prototypes */
+
+long adapt_interval(MainUi *, long);
+double usage_velocity(ServUsage *, MainUi *, double, double);
+double isp_velocity(double, double);
+double local_velocity(double);
+int default_route_if();
+double hist_velocity(ServUsage *);
+
+extern ServUsage * get_service_usage();
+extern int link_stats(LinkStats **, int *);
+extern int netdev_list(IfEntry **);
+extern int netdev_ready();
+extern int netdev_active(IfEntry *);
+extern double mono_time();
+extern long mon_pref(char *, long, long);
+extern time_t string2tm(char *, struct tm *);
+extern double difftime_days(time_t, time_t);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-burn_rate.c ";
+static const double thresholds[] = { 0.8, 0.9, 1.0 };
+static double isp_t = 0;			// When the ISP total last changed (monotonic)
+static double isp_used = -1;
+static double isp_v = 0;
+static double lcl_t = 0;			// Last local counter sample (monotonic)
+static unsigned long long lcl_bytes = 0;
+static int lcl_ifindex = 0;
+static LinkStats *ls = NULL;
+static int ls_max = 0;
+
+
+
+/* Next refresh (secs) based on the usage rate, or the default if usage is not in bytes */
+
+long adapt_interval(MainUi *m_ui, long dflt)
+{
+    int i;
+    long min_s, max_s;
+    double used, quota, v, now, t, intvl;
+    ServUsage *srv_usg;
+
+    /* Bounds (mins) */
+    min_s = mon_pref(REFRESH_MIN, 5, 1) * 60;
+    max_s = mon_pref(REFRESH_MAX, 120, 1) * 60;
+
+    if (max_s < min_s)
+    	max_s = min_s;
+
+    srv_usg = get_service_usage();
+
+    if (srv_usg->unit == NULL || strncmp(srv_usg->unit, "byte", 4) != 0)
+    	return dflt;
+
+    if (srv_usg->quota == NULL || srv_usg->total_bytes == NULL)
+    	return dflt;
+
+    quota = atof(srv_usg->quota);
+    used = atof(srv_usg->total_bytes);
+
+    if (quota <= 0)
+    	return dflt;
+
+    now = mono_time();
+    v = usage_velocity(srv_usg, m_ui, used, now);
+    intvl = (double) max_s;
+
+    /* Time to the next threshold not yet reached */
+    for(i = 0; i < (int) (sizeof(thresholds) / sizeof(double)); i++)
+    {
+	if (used < quota * thresholds[i])
+	{
+	    if (v > 0)
+	    {
+		t = ((quota * thresholds[i]) - used) / v;
+
+		if (t / 2.0 < intvl)
+		    intvl = t / 2.0;
+	    }
+
+	    break;
+	}
+    }
+
+    /* Just after rollover */
+    t = (m_ui->days_rem * 86400.0) + 60.0;
+
+    if (t > 0 && t < intvl)
+    	intvl = t;
+
+    if (intvl < min_s)
+    	intvl = min_s;
+
+    if (intvl > max_s)
+    	intvl = max_s;
+
+    return (long) intvl;
+}
+
+
+/* Bytes per second - the highest of the estimates available */
+
+double usage_velocity(ServUsage *srv_usg, MainUi *m_ui, double used, double now)
+{
+    double v, tmp, elapsed;
+
+    v = isp_velocity(used, now);
+
+    if ((tmp = local_velocity(now)) > v)
+    	v = tmp;
+
+    if ((tmp = hist_velocity(srv_usg)) > v)
+    	v = tmp;
+
+    /* Average this period */
+    elapsed = m_ui->days_quota - m_ui->days_rem;
+
+    if (elapsed > 0 && (tmp = used / (elapsed * 86400.0)) > v)
+    	v = tmp;
+
+    return v;
+}
+
+
+/* Change in the ISP total. The ISP updates its figure only now and then, so the rate is taken
+   between changes and held until the next change */
+
+double isp_velocity(double used, double now)
+{
+    if (isp_used < 0 || used < isp_used)		// First time or new period
+    {
+	isp_used = used;
+	isp_t = now;
+	isp_v = 0;
+    }
+    else if (used > isp_used)
+    {
+	isp_v = (used - isp_used) / (now - isp_t);
+	isp_used = used;
+	isp_t = now;
+    }
+
+    return isp_v;
+}
+
+
+/* Local traffic (default route interface, in and out) since the last refresh. LAN only
+   traffic on other devices does not count against the quota so is left out */
+
+double local_velocity(double now)
+{
+    int i, j, n, cnt, ifindex;
+    unsigned long long bytes;
+    double v;
+    IfEntry *ifs;
+
+    /* No devices to count yet (found in the background at startup) */
+    if (netdev_ready() == FALSE)
+    	return 0;
+
+    /* No route to the ISP, no estimate */
+    if ((ifindex = default_route_if()) == 0)
+    {
+	lcl_t = 0;
+    	return 0;
+    }
+
+    if ((cnt = link_stats(&ls, &ls_max)) <= 0)
+    	return 0;
+
+    n = netdev_list(&ifs);
+    bytes = 0;
+
+    for(i = 0; i < cnt; i++)
+    {
+	if (ls[i].ifindex != ifindex)
+	    continue;
+
+	for(j = 0; j < n; j++)
+	{
+	    if (ifs[j].ifindex == ifindex)
+	    {
+		if (netdev_active(&(ifs[j])) == TRUE)
+		    bytes = ls[i].rx_bytes + ls[i].tx_bytes;
+
+		break;
+	    }
+	}
+
+	break;
+    }
+
+    v = 0;
+
+    /* A change of route restarts the sample */
+    if (lcl_t > 0 && ifindex == lcl_ifindex && bytes >= lcl_bytes && now > lcl_t)
+	v = (double) (bytes - lcl_bytes) / (now - lcl_t);
+
+    lcl_bytes = bytes;
+    lcl_ifindex = ifindex;
+    lcl_t = now;
+
+    return v;
+}
+
+
+/* Index of the interface holding the IPv4 default route (lowest metric), 0 if none */
+
+int default_route_if()
+{
+    int i, ifindex, metric, best;
+    unsigned int dest, flags;
+    char buf[256], nm[LINK_NAME_SZ];
+    FILE *fd;
+
+    if ((fd = fopen(PROC_NET_ROUTE, "r")) == NULL)
+    	return 0;
+
+    ifindex = 0;
+    best = -1;
+
+    /* Iface Destination Gateway Flags RefCnt Use Metric Mask ... (first line is a header) */
+    while(fgets(buf, sizeof(buf), fd) != NULL)
+    {
+	if (sscanf(buf, "%15s %x %*x %x %*d %*d %d", nm, &dest, &flags, &metric) != 4)
+	    continue;
+
+	if (dest != 0 || (flags & RTF_UP) == 0)
+	    continue;
+
+	if (best >= 0 && metric >= best)
+	    continue;
+
+	if ((i = (int) if_nametoindex(nm)) > 0)
+	{
+	    ifindex = i;
+	    best = metric;
+	}
+    }
+
+    fclose(fd);
+
+    return ifindex;
+}
+
+
+/* Average of recent whole days, if the history loaded runs up to (about) today */
+
+double hist_velocity(ServUsage *srv_usg)
+{
+    int i, n;
+    long long tot;
+    time_t tmt_to;
+    struct tm tm_to;
+
+    /* Index 0 is not used and the last day is still in progress */
+    if (srv_usg->hist_days < 3 || srv_usg->hist_usg_arr == NULL)
+    	return 0;
+
+    tmt_to = string2tm(srv_usg->hist_to_dt, &tm_to);
+
+    if (difftime_days(time(NULL), tmt_to) > 2.0)
+    	return 0;
+
+    tot = 0;
+    n = 0;
+
+    for(i = srv_usg->hist_days - 2; i >= 1 && n < HIST_DAYS; i--, n++)
+	tot += srv_usg->hist_usg_arr[i][0];		// Total (up and down)
+
+    if (n == 0)
+    	return 0;
+
+    return (double) tot / (n * 86400.0);
+}
@@ -25,6 +25,13 @@
 **
 ** History
 **	28-Jul-2017	Initial code
+**	19-Oct-2026	Cached chart image, an expose is just a paint unless the size or data change
+**	19-Oct-2026	Text extents cache and binary search font sizing
+**	19-Oct-2026	Line graph points in arrays, drawn as a single path
+**	19-Oct-2026	Line graph points decimated (LTTB) to the plot width
+**	19-Oct-2026	Line graph series (shared axes) with a legend
+**	19-Oct-2026	Axis step mark labels and fitted points kept until the steps or size change
+**	19-Oct-2026	Cached image current check, free any recording
 **
 */
 
@@ -47,6 +54,10 @@
 
 /* Defines */
 
+#define EXT_CACHE_MAX 2000
+#define MIN_FONT_SZ 5
+#define LG_INIT_POINTS 64
+
 
 /* Types */
 
@@ -70,6 +81,10 @@ void free_axis(Axis *);
 int draw_axis(cairo_t *, Axis *, int, GtkAllocation *);
 void axes_auto_fit(cairo_t *, Axis *, Axis *, GtkAllocation *);
 void axis_step_bounds(Axis *);
+void axis_ticks(cairo_t *, Axis *, int);
+void free_axis_ticks(Axis *);
+int axis_fit_same(Axis *, GtkAllocation *);
+void axis_fit_save(Axis *, GtkAllocation *);
 
 BarChart * bar_chart_create(char *, const GdkRGBA *, int, int, Axis *, Axis *);
 Bar * bar_create(BarChart *);
@@ -85,14 +100,17 @@ LineGraph * line_graph_create(char *, const GdkRGBA *, int,
 			      char *, double, double,
 			      const GdkRGBA *, int, const GdkRGBA *, int,
 			      char *, double, double,
-			      const GdkRGBA *, int, const GdkRGBA *, int,
-			      const GdkRGBA *);
+			      const GdkRGBA *, int, const GdkRGBA *, int);
+LineSeries * line_graph_add_series(LineGraph *, char *, const GdkRGBA *);
 void free_line_graph(LineGraph *);
-void free_points(gpointer);
+void free_series(gpointer);
 void draw_line_graph(cairo_t *, LineGraph *, GtkAllocation *);
-void draw_point_line(cairo_t *, double, double, double, double);
-void line_graph_add_point(LineGraph *, double, double);
+void draw_series(cairo_t *, LineGraph *, LineSeries *, double, double);
+double draw_lg_legend(cairo_t *, LineGraph *, GtkAllocation *);
+void line_graph_add_point(LineGraph *, LineSeries *, double, double);
+void line_graph_series_visible(LineGraph *, int, int);
 void set_line_graph_bounds(LineGraph *);
+int lttb_decimate(const double *, const double *, int, int, double *, double *);
 
 int chart_title(cairo_t *, CText *, GtkAllocation *, GtkAlign, GtkAlign);
 CText * label_text(int, CText *);
@@ -104,6 +122,13 @@ CText * new_chart_text(char *, const GdkRGBA *, int);
 void free_chart_text(CText *);
 void get_ctext_ext(cairo_t *, CText *);
 void show_surface_info(cairo_t *, GtkAllocation *);
+int chart_cache_current(ChartCache *, cairo_t *, GtkAllocation *);
+cairo_t * chart_cache_cr(ChartCache *, cairo_t *, GtkAllocation *);
+void chart_cache_paint(cairo_t *, ChartCache *, cairo_t *);
+void chart_cache_inval(ChartCache *);
+void chart_cache_free(ChartCache *);
+void chart_text_extents(cairo_t *, char *, double, cairo_text_extents_t *);
+void chart_text_cache_free();
 
 extern int long_chars(long);
 extern int double_chars(double);
@@ -113,6 +138,7 @@ char * dtos(double, int);
 /* Globals */
 
 static const char *debug_hdr = "DEBUG-cairo_chart.c ";
+static GHashTable *ext_cache = NULL;
 static const double lgd_rect_width = 20.0;
 static const double lgd_buf = 5.0;
 static const double r_rad = 0.7;
@@ -436,14 +462,12 @@ int check_legend(cairo_t *cr, PieChart *pc,
 	    return FALSE;
 
 	desc = ps->desc;
-	cairo_set_font_size (cr, (double) desc->sz);
-	cairo_text_extents (cr, desc->txt, &(desc->ext));
+	chart_text_extents (cr, desc->txt, (double) desc->sz, &(desc->ext));
 
 	if (ps->perc_txt != NULL)
 	{
 	    desc = ps->perc_txt;
-	    cairo_set_font_size (cr, (double) desc->sz);
-	    cairo_text_extents (cr, desc->txt, &(desc->ext));
+	    chart_text_extents (cr, desc->txt, (double) desc->sz, &(desc->ext));
 	}
     }
 
@@ -866,7 +890,7 @@ printf("%s draw bar 2 xc %0.4f yc %0.4f bar_w %d seg_h %0.4f\n", debug_hdr, xc,
 }
 
 
-/* Create and initialise a new line graph */
+/* Create and initialise a new line graph (series are added separately) */
 
 LineGraph * line_graph_create(char *title, const GdkRGBA *txt_colour, int txt_sz, 
 			      char *x_unit, double x_step, double x_prec,
@@ -874,8 +898,7 @@ LineGraph * line_graph_create(char *title, const GdkRGBA *txt_colour, int txt_sz
 			      const GdkRGBA *x_step_colour, int x_step_txt_sz,
 			      char *y_unit, double y_step, double y_prec,
 			      const GdkRGBA *y_txt_colour, int y_txt_sz,
-			      const GdkRGBA *y_step_colour, int y_step_txt_sz,
-			      const GdkRGBA *line_colour)
+			      const GdkRGBA *y_step_colour, int y_step_txt_sz)
 {
     LineGraph *lg;
 
@@ -901,15 +924,32 @@ LineGraph * line_graph_create(char *title, const GdkRGBA *txt_colour, int txt_sz
     	return NULL;
     }
 
-    lg->points = NULL;
-
-    /* General */
-    lg->line_colour = line_colour;
+    lg->series = NULL;
+    lg->n_points = 0;
 
     return lg;
 }
 
 
+/* Add a series (line) to a line graph */
+
+LineSeries * line_graph_add_series(LineGraph *lg, char *name, const GdkRGBA *colour)
+{
+    LineSeries *ls;
+
+    ls = (LineSeries *) malloc(sizeof(LineSeries));
+    memset(ls, 0, sizeof(LineSeries));
+
+    ls->name = new_chart_text(name, &BLACK, 8);
+    ls->colour = colour;
+    ls->visible = TRUE;
+
+    lg->series = g_list_append(lg->series, ls);
+
+    return ls;
+}
+
+
 /* Free all line graph resources */
 
 void free_line_graph(LineGraph *lg)
@@ -923,8 +963,8 @@ void free_line_graph(LineGraph *lg)
     if (lg->y_axis != NULL)
     	free_axis(lg->y_axis);
 
-    if (lg->points != NULL)
-    	g_list_free_full(lg->points, (GDestroyNotify) free_points);
+    if (lg->series != NULL)
+    	g_list_free_full(lg->series, (GDestroyNotify) free_series);
 
     free(lg);
 
@@ -932,73 +972,102 @@ void free_line_graph(LineGraph *lg)
 }
 
 
-/* Free a line graph point */
+/* Free a line graph series */
 
-void free_points(gpointer data)
+void free_series(gpointer data)
 {  
-    Point *p;
+    LineSeries *ls;
 
-    p = (Point *) data;
-    free(p);
+    ls = (LineSeries *) data;
 
-    return;
-}
+    if (ls->name != NULL)
+    	free_chart_text(ls->name);
 
+    if (ls->x_vals != NULL)
+    	free(ls->x_vals);
 
-/* Add a line graph point */
+    if (ls->y_vals != NULL)
+    	free(ls->y_vals);
 
-void line_graph_add_point(LineGraph *lg, double x, double y)
-{  
-    Point *p;
+    if (ls->dec_x != NULL)
+    	free(ls->dec_x);
 
-    p = (Point *) malloc(sizeof(Point));
-    p->x_val = x;
-    p->y_val = y;
+    if (ls->dec_y != NULL)
+    	free(ls->dec_y);
 
-    lg->points = g_list_append(lg->points, p);
+    free(ls);
 
     return;
 }
 
 
-/* Set the axes high and low points */
+/* Add a point to a series (the arrays double in size as required) and track the graph bounds */
 
-void set_line_graph_bounds(LineGraph *lg)
+void line_graph_add_point(LineGraph *lg, LineSeries *ls, double x, double y)
 {  
-    double min_x, max_x, min_y, max_y;
-    GList *l;
-    Point *p;
-
-    /* Data high and low values */
-    l = lg->points;
-    p = (Point *) l->data;
+    int n;
 
-    min_x = max_x = p->x_val;
-    min_y = max_y = p->y_val;
-    l = l->next;
+    if (ls->n_points >= ls->max_points)
+    {
+	n = (ls->max_points == 0) ? LG_INIT_POINTS : ls->max_points * 2;
+	ls->x_vals = (double *) realloc(ls->x_vals, n * sizeof(double));
+	ls->y_vals = (double *) realloc(ls->y_vals, n * sizeof(double));
+	ls->max_points = n;
+    }
 
-    while(l != NULL)
+    /* Bounds are across all series so they share the axes */
+    if (lg->n_points == 0)
     {
-	p = (Point *) l->data;
+	lg->min_x = lg->max_x = x;
+	lg->min_y = lg->max_y = y;
+    }
+    else
+    {
+	if (x < lg->min_x)
+	    lg->min_x = x;
 
-	if (p->x_val < min_x)
-	    min_x = p->x_val;
-	else if (p->x_val > max_x)
-	    max_x = p->x_val;
-    	
+	if (x > lg->max_x)
+	    lg->max_x = x;
 
-	if (p->y_val < min_y)
-	    min_y = p->y_val;
-	else if (p->y_val > max_y)
-	    max_y = p->y_val;
+	if (y < lg->min_y)
+	    lg->min_y = y;
 
-	l = l->next;
+	if (y > lg->max_y)
+	    lg->max_y = y;
     }
 
-    lg->x_axis->low_val = min_x;
-    lg->x_axis->high_val = max_x;
-    lg->y_axis->low_val = min_y;
-    lg->y_axis->high_val = max_y;
+    ls->x_vals[ls->n_points] = x;
+    ls->y_vals[ls->n_points] = y;
+    ls->n_points++;
+    ls->dec_width = 0;
+    lg->n_points++;
+
+    return;
+}
+
+
+/* Show or hide a series (by its index), this only needs a redraw */
+
+void line_graph_series_visible(LineGraph *lg, int idx, int visible)
+{  
+    LineSeries *ls;
+
+    if ((ls = (LineSeries *) g_list_nth_data(lg->series, idx)) != NULL)
+	ls->visible = visible;
+
+    return;
+}
+
+
+/* Set the axes high and low points */
+
+void set_line_graph_bounds(LineGraph *lg)
+{  
+    /* Data high and low values (these are kept as points are added) */
+    lg->x_axis->low_val = lg->min_x;
+    lg->x_axis->high_val = lg->max_x;
+    lg->y_axis->low_val = lg->min_y;
+    lg->y_axis->high_val = lg->max_y;
 
     /* Round out the axes high and low step bounds */
     axis_step_bounds(lg->x_axis);
@@ -1036,60 +1105,231 @@ void axis_step_bounds(Axis *axis)
 
 void draw_line_graph(cairo_t *cr, LineGraph *lg, GtkAllocation *allocation)
 {  
-    int init;
-    double x, y, prev_x, prev_y, x_factor, y_factor;
+    double x_factor, y_factor;
     GList *l;
-    Point *pt;
-    const GdkRGBA *rgba;
+    GtkAllocation plot_alloc;
+
+    /* Legend (if more than one series) goes above the plot */
+    memcpy(&plot_alloc, allocation, sizeof(GtkAllocation));
+
+    if (g_list_length(lg->series) > 1)
+	plot_alloc.y += (int) draw_lg_legend(cr, lg, allocation);
 
     /* Draw the axes first */
-    axes_auto_fit(cr, lg->x_axis, lg->y_axis, allocation);
-    draw_axis(cr, lg->x_axis, FALSE, allocation);
-    draw_axis(cr, lg->y_axis, FALSE, allocation);
+    axes_auto_fit(cr, lg->x_axis, lg->y_axis, &plot_alloc);
+    draw_axis(cr, lg->x_axis, FALSE, &plot_alloc);
+    draw_axis(cr, lg->y_axis, FALSE, &plot_alloc);
+
+    if (lg->n_points == 0)
+    	return;
 
-    /* Plot each point */
+    /* Plot each visible series */
     x_factor = (lg->x_axis->x2 - lg->x_axis->x1) / (lg->x_axis->high_step - lg->x_axis->low_step);
     y_factor = (lg->y_axis->y2 - lg->y_axis->y1) / (lg->y_axis->high_step - lg->y_axis->low_step);
-    init = TRUE;
+
+    for(l = lg->series; l != NULL; l = l->next)
+	draw_series(cr, lg, (LineSeries *) l->data, x_factor, y_factor);
+
+    return;
+}
+
+
+/* Draw a line graph series as a single path */
+
+void draw_series(cairo_t *cr, LineGraph *lg, LineSeries *ls, double x_factor, double y_factor)
+{  
+    int i, n, w;
+    double x_org, y_org;
+    double *xv, *yv;
+    const GdkRGBA *rgba;
+
+    if (ls->visible == FALSE || ls->n_points == 0)
+    	return;
+
+    x_org = lg->x_axis->x1;
+    y_org = lg->y_axis->y2;
+
+    /* There is no point drawing more points than the plot has pixels across, reduce if need be */
+    w = (int) (lg->x_axis->x2 - lg->x_axis->x1);
+
+    if (w < 3)
+    	w = 3;
+
+    if (ls->n_points > w)
+    {
+	if (ls->dec_width != w)
+	{
+	    ls->dec_x = (double *) realloc(ls->dec_x, w * sizeof(double));
+	    ls->dec_y = (double *) realloc(ls->dec_y, w * sizeof(double));
+	    ls->dec_n = lttb_decimate(ls->x_vals, ls->y_vals, ls->n_points, w, ls->dec_x, ls->dec_y);
+	    ls->dec_width = w;
+	}
+
+	xv = ls->dec_x;
+	yv = ls->dec_y;
+	n = ls->dec_n;
+    }
+    else
+    {
+	xv = ls->x_vals;
+	yv = ls->y_vals;
+	n = ls->n_points;
+    }
+
     cairo_set_line_width (cr, 1.0); 
-    rgba = lg->line_colour;
+    cairo_set_line_join (cr, CAIRO_LINE_JOIN_ROUND);
+    rgba = ls->colour;
     cairo_set_source_rgba (cr, rgba->red, rgba->green, rgba->blue, rgba->alpha);
 
-    for(l = lg->points; l != NULL; l = l->next)
+    /* Tranform each x,y point value into corresponding graph x,y values and build one path */
+    cairo_new_path (cr);
+    cairo_move_to (cr, x_org + (xv[0] * x_factor), y_org - (yv[0] * y_factor));
+
+    for(i = 1; i < n; i++)
+	cairo_line_to (cr, x_org + (xv[i] * x_factor), y_org - (yv[i] * y_factor));
+
+    cairo_stroke (cr);
+
+    return;
+}
+
+
+/* Draw a line graph legend across the top of the allocation, return the height used */
+
+// Each series has a short line in its colour and its name. Hidden series are shown faded 
+// so the legend does not move about as series are toggled.
+
+double draw_lg_legend(cairo_t *cr, LineGraph *lg, GtkAllocation *allocation)
+{  
+    double x, y, w, row_h;
+    GList *l;
+    LineSeries *ls;
+    CText *nm;
+    const GdkRGBA *rgba;
+    const double swatch = 12.0;
+    const double gap = 4.0;
+
+    x = allocation->x + axis_buf;
+    y = allocation->y + axis_buf;
+    row_h = 0;
+
+    for(l = lg->series; l != NULL; l = l->next)
     {
-	/* Tranform each x,y point value into corresponding graph x,y values */
-    	pt = (Point *) l->data;
-    	x = lg->x_axis->x1 + (pt->x_val * x_factor);
-    	y = lg->y_axis->y2 - (pt->y_val * y_factor);
+	ls = (LineSeries *) l->data;
+	nm = ls->name;
+	chart_text_extents (cr, nm->txt, (double) nm->sz, &(nm->ext));
+
+	if (nm->ext.height > row_h)
+	    row_h = nm->ext.height;
+
+	/* Wrap if the item will not fit */
+	w = swatch + gap + nm->ext.width + (gap * 3);
 
-	/* Draw a line to each point, except the first */
-	if (init == FALSE)
+	if (x + w > allocation->x + allocation->width && x > allocation->x + axis_buf)
 	{
-	    draw_point_line(cr, x, y, prev_x, prev_y);
+	    x = allocation->x + axis_buf;
+	    y += row_h + gap;
+	}
+
+	rgba = ls->colour;
+	cairo_set_source_rgba (cr, rgba->red, rgba->green, rgba->blue, (ls->visible) ? rgba->alpha : 0.25);
+	cairo_set_line_width (cr, 2.0); 
+	cairo_move_to (cr, x, y + (row_h / 2.0));
+	cairo_line_to (cr, x + swatch, y + (row_h / 2.0));
+	cairo_stroke (cr);
+
+	rgba = nm->colour;
+	cairo_set_source_rgba (cr, rgba->red, rgba->green, rgba->blue, (ls->visible) ? rgba->alpha : 0.4);
+	cairo_move_to (cr, x + swatch + gap, y + row_h);
+	cairo_show_text (cr, nm->txt);
+
+	x += w;
+    }
+
+    return (y + row_h + gap) - allocation->y;
+}
+
+
+/* Largest Triangle Three Buckets downsampling */
+
+// Reduces n points to 'thr' points (thr >= 3) keeping the visual shape. The first and last 
+// points are kept, the rest are split into buckets and the point chosen from each is the one 
+// forming the largest triangle with the last chosen point and the average of the next bucket.
+// Returns the number of points output.
+
+int lttb_decimate(const double *x, const double *y, int n, int thr, double *ox, double *oy)
+{
+    int i, j, a, o, nxt, start, end, max_idx;
+    double every, avg_x, avg_y, area, max_area;
+
+    if (thr >= n || thr < 3)
+    {
+	memcpy(ox, x, n * sizeof(double));
+	memcpy(oy, y, n * sizeof(double));
+    	return n;
+    }
+
+    every = (double) (n - 2) / (double) (thr - 2);
+    a = 0;
+    o = 0;
+    ox[o] = x[0];
+    oy[o++] = y[0];
+
+    for(i = 0; i < thr - 2; i++)
+    {
+	/* Average of the next bucket (the last point for the final bucket) */
+	nxt = (int) floor((i + 1) * every) + 1;
+	end = (int) floor((i + 2) * every) + 1;
+
+	if (end > n)
+	    end = n;
+
+	avg_x = 0;
+	avg_y = 0;
+
+	for(j = nxt; j < end; j++)
+	{
+	    avg_x += x[j];
+	    avg_y += y[j];
+	}
+
+	if (end > nxt)
+	{
+	    avg_x /= (end - nxt);
+	    avg_y /= (end - nxt);
 	}
 	else
 	{
-	    init = FALSE;
-	    draw_point_line(cr, x, y, x, y);
+	    avg_x = x[n - 1];
+	    avg_y = y[n - 1];
 	}
 
-	prev_x = x;
-	prev_y = y;
-    }
+	/* Point in this bucket giving the largest triangle */
+	start = (int) floor(i * every) + 1;
+	end = nxt;
+	max_area = -1;
+	max_idx = start;
 
-    return;
-}
+	for(j = start; j < end; j++)
+	{
+	    area = fabs((x[a] - avg_x) * (y[j] - y[a]) - (x[a] - x[j]) * (avg_y - y[a]));
 
+	    if (area > max_area)
+	    {
+		max_area = area;
+		max_idx = j;
+	    }
+	}
 
-/* Draw a line graph line connecting two points */
+	ox[o] = x[max_idx];
+	oy[o++] = y[max_idx];
+	a = max_idx;
+    }
 
-void draw_point_line(cairo_t *cr, double x, double y, double prev_x, double prev_y)
-{  
-    cairo_move_to (cr, x, y);
-    cairo_line_to (cr, prev_x, prev_y);
-    cairo_stroke (cr);
+    ox[o] = x[n - 1];
+    oy[o++] = y[n - 1];
 
-    return;
+    return o;
 }
 
 
@@ -1121,8 +1361,6 @@ Axis * create_axis(char *unit, double step, int prec,
     axis->x2 = -1;
     axis->y2 = -1;
 
-    axis->unit = new_chart_text(unit, txt_colour, txt_sz);
-
     /* Set up */
     axis->step = step;
     axis->prec = prec;
@@ -1147,6 +1385,7 @@ void free_axis(Axis *axis)
     if (axis->step_mk != NULL)
     	free_chart_text(axis->step_mk);
 
+    free_axis_ticks(axis);
     free(axis);
 
     return;
@@ -1160,9 +1399,8 @@ int draw_axis(cairo_t *cr, Axis *axis, int check_space, GtkAllocation *allocatio
     int i, n_steps;
     double step_dist, tmpx, tmpy, rem, tmp;
     double x_offset, y_offset, x_mk_offset, y_mk_offset;
-    char *s;
     CText *unit, *step_mk;
-    cairo_text_extents_t ext;
+    cairo_text_extents_t *ext;
     const GdkRGBA *rgba;
 
     /* Step and axis determination (rounding if required) */
@@ -1214,7 +1452,8 @@ int draw_axis(cairo_t *cr, Axis *axis, int check_space, GtkAllocation *allocatio
     tmpy = axis->y2; 
     cairo_move_to (cr, axis->x2, axis->y2);
 
-    /* Step mark settings */
+    /* Step mark settings (labels are only redone if the steps have changed) */
+    axis_ticks(cr, axis, n_steps);
     cairo_set_font_size (cr, axis->step_mk->sz);
     rgba = axis->step_mk->colour;
 
@@ -1227,19 +1466,16 @@ int draw_axis(cairo_t *cr, Axis *axis, int check_space, GtkAllocation *allocatio
 	cairo_stroke_preserve (cr);
 
 	/* Draw the step text */
-	tmp = axis->high_step - (axis->step * (double) i);
-	s = dtos(tmp, axis->prec);
+	ext = &(axis->tick_ext[i]);
 	cairo_set_source_rgba (cr, rgba->red, rgba->green, rgba->blue, rgba->alpha);
-	cairo_text_extents (cr, s, &ext);
 
 	if (axis->y1 == axis->y2)	// X axis
-	    cairo_move_to (cr, tmpx - (ext.width/2), tmpy + axis_buf + ext.height);
+	    cairo_move_to (cr, tmpx - (ext->width/2), tmpy + axis_buf + ext->height);
 	else				// Y axis
-	    cairo_move_to (cr, tmpx - axis_buf - ext.width, tmpy + (ext.height/2));
+	    cairo_move_to (cr, tmpx - axis_buf - ext->width, tmpy + (ext->height/2));
 
-    	cairo_show_text (cr, s);
+    	cairo_show_text (cr, axis->tick_txt[i]);
 	cairo_fill (cr);
-	free(s);
 
 	/* Move to next step mark */
 	tmpx -= x_offset;
@@ -1297,6 +1533,106 @@ printf("%s draw_axis  low val: %0.3f high val: %0.3f step: %0.3f high_step: %0.3
 }
 
 
+/* Step mark labels and their extents for the current steps */
+
+// Built once for a given low & high step, step, precision and font size. Redraws at 
+// the same steps reuse them (no string formatting or measuring).
+
+void axis_ticks(cairo_t *cr, Axis *axis, int n_steps)
+{
+    int i;
+    double tmp;
+
+    if (axis->tick_txt != NULL
+    	&& axis->n_ticks == n_steps + 1
+	&& axis->tk_low == axis->low_step
+	&& axis->tk_high == axis->high_step
+	&& axis->tk_step == axis->step
+	&& axis->tk_prec == axis->prec
+	&& axis->tk_sz == (double) axis->step_mk->sz)
+    	return;
+
+    free_axis_ticks(axis);
+
+    axis->n_ticks = n_steps + 1;
+    axis->tick_txt = (char **) malloc(axis->n_ticks * sizeof(char *));
+    axis->tick_ext = (cairo_text_extents_t *) malloc(axis->n_ticks * sizeof(cairo_text_extents_t));
+
+    /* Labels run from the axis end backwards (as drawn) */
+    for(i = 0; i < axis->n_ticks; i++)
+    {
+	tmp = axis->high_step - (axis->step * (double) i);
+	axis->tick_txt[i] = dtos(tmp, axis->prec);
+	chart_text_extents (cr, axis->tick_txt[i], (double) axis->step_mk->sz, &(axis->tick_ext[i]));
+    }
+
+    axis->tk_low = axis->low_step;
+    axis->tk_high = axis->high_step;
+    axis->tk_step = axis->step;
+    axis->tk_prec = axis->prec;
+    axis->tk_sz = (double) axis->step_mk->sz;
+
+    return;
+}
+
+
+/* Free the step mark labels */
+
+void free_axis_ticks(Axis *axis)
+{
+    int i;
+
+    if (axis->tick_txt != NULL)
+    {
+	for(i = 0; i < axis->n_ticks; i++)
+	    free(axis->tick_txt[i]);
+
+	free(axis->tick_txt);
+    }
+
+    if (axis->tick_ext != NULL)
+	free(axis->tick_ext);
+
+    axis->tick_txt = NULL;
+    axis->tick_ext = NULL;
+    axis->n_ticks = 0;
+
+    return;
+}
+
+
+/* Check if an axis was last fitted for this allocation and these steps */
+
+int axis_fit_same(Axis *axis, GtkAllocation *allocation)
+{
+    if (axis->fit_ok == FALSE)
+    	return FALSE;
+
+    if (axis->fit_alloc.x != allocation->x || axis->fit_alloc.y != allocation->y
+    	|| axis->fit_alloc.width != allocation->width || axis->fit_alloc.height != allocation->height)
+    	return FALSE;
+
+    if (axis->fit_low != axis->low_step || axis->fit_high != axis->high_step || axis->fit_step != axis->step)
+    	return FALSE;
+
+    return TRUE;
+}
+
+
+/* Record the allocation and steps an axis was fitted for */
+
+void axis_fit_save(Axis *axis, GtkAllocation *allocation)
+{
+    memcpy(&(axis->fit_alloc), allocation, sizeof(GtkAllocation));
+    axis->fit_low = axis->low_step;
+    axis->fit_high = axis->high_step;
+    axis->fit_step = axis->step;
+    axis->fit_ok = TRUE;
+
+    return;
+}
+
+
 /* Determine the best coordinates for X and Y axes as far as possible */
 
 void axes_auto_fit(cairo_t *cr, Axis *x_axis, Axis *y_axis, GtkAllocation *allocation)
@@ -1305,6 +1641,10 @@ void axes_auto_fit(cairo_t *cr, Axis *x_axis, Axis *y_axis, GtkAllocation *alloc
     cairo_text_extents_t *ext;
     CText *txt;
 
+    /* Nothing to do if the size and steps are as last fitted */
+    if (axis_fit_same(x_axis, allocation) && axis_fit_same(y_axis, allocation))
+    	return;
+
     /* If not already set get the space used by axis titles, step mark values and step marks */
     get_ctext_ext(cr, x_axis->unit);
     get_ctext_ext(cr, x_axis->step_mk);
@@ -1379,6 +1719,10 @@ void axes_auto_fit(cairo_t *cr, Axis *x_axis, Axis *y_axis, GtkAllocation *alloc
     /* Since X and Y axes always intersect at 0,0 the zero point forms the x axis y1 and y2 points */
     x_axis->y1 = x_axis->y2 = xyz;
 
+    /* Save what the fit was for */
+    axis_fit_save(x_axis, allocation);
+    axis_fit_save(y_axis, allocation);
+
 /*
 printf("***AUTO 1 axis_len: %0.2f alloc width %d x %d axis_buf %0.2f\n", 
 		axis_len, allocation->width, allocation->x,axis_buf); fflush(stdout);
@@ -1434,11 +1778,9 @@ int chart_title(cairo_t *cr, CText *title, GtkAllocation *allocation, GtkAlign h
     if ((fsz = confirm_font_size(cr, title->txt, allocation->width, title->sz)) == FALSE)
     	return FALSE;
 
-    cairo_set_font_size (cr, fsz);
-
     /* Determine space to be consumed by text */
     ext = &(title->ext);
-    cairo_text_extents (cr, title->txt, ext);
+    chart_text_extents (cr, title->txt, fsz, ext);
 
     /* Set alignment */
     switch (h_align)
@@ -1515,8 +1857,7 @@ void draw_text_lines(cairo_t *cr, CText *txt[], int max, int w, double xc, doubl
 	if (fsz != ctxt->sz)
 	{
 	    ctxt->sz = fsz;
-	    cairo_set_font_size (cr, ctxt->sz);
-	    cairo_text_extents (cr, ctxt->txt, &(ctxt->ext));
+	    chart_text_extents (cr, ctxt->txt, (double) ctxt->sz, &(ctxt->ext));
 	}
     }
     
@@ -1604,45 +1945,55 @@ CText * percent_text(cairo_t *cr, CText *perc_txt, double item_val, double total
     else
     {
 	sprintf(perc_txt->txt, "(%0.1f%%)", pc);
-	cairo_set_font_size (cr, (double) base_ctext->sz);
-	cairo_text_extents (cr, base_ctext->txt, &(base_ctext->ext));
+	chart_text_extents (cr, base_ctext->txt, (double) base_ctext->sz, &(base_ctext->ext));
     }
 
-    cairo_set_font_size (cr, (double) perc_txt->sz);
-    cairo_text_extents (cr, perc_txt->txt, &(perc_txt->ext));
+    chart_text_extents (cr, perc_txt->txt, (double) perc_txt->sz, &(perc_txt->ext));
 
     return perc_txt;
 }
 
 
 /* Confirm and override the font size if necessary */
+// Find the largest of sz, sz - 1, ... (not below the minimum) that fits the width.
+// Text width grows with font size so a binary search will do.
 
 double confirm_font_size(cairo_t *cr, char *txt, int w, double sz)
 {
-    double sz_ok, fsz;
+    int lo, hi, mid;
+    double sz_ok;
     cairo_text_extents_t ext;
 
+    /* Usual case, the requested size fits */
+    chart_text_extents (cr, txt, sz, &ext);
+
+    if (ext.width <= w)
+    	return sz;
+
+    /* Search the number of points to drop */
+    lo = 1;
+    hi = (int) (sz - MIN_FONT_SZ);
     sz_ok = (double) FALSE;
-    fsz = sz;
 
-    while (sz_ok == (double) FALSE)
+    while (lo <= hi)
     {
-	cairo_set_font_size (cr, fsz);
-	cairo_text_extents (cr, txt, &ext);
+	mid = (lo + hi) / 2;
+	chart_text_extents (cr, txt, sz - mid, &ext);
 
 	if (ext.width > w)
 	{
-	    fsz--;
-
-	    if (fsz < 5)
-	    	break;
+	    lo = mid + 1;
 	}
 	else
 	{
-	    sz_ok = fsz;
+	    sz_ok = sz - mid;
+	    hi = mid - 1;
 	}
     }
 
+    if (sz_ok != (double) FALSE)
+	cairo_set_font_size (cr, sz_ok);
+
     return sz_ok;
 }
 
@@ -1693,8 +2044,7 @@ void free_chart_text(CText *ctext)
 
 void get_ctext_ext(cairo_t *cr, CText *ctext)
 {
-    cairo_set_font_size (cr, ctext->sz);
-    cairo_text_extents (cr, ctext->txt, &(ctext->ext));
+    chart_text_extents (cr, ctext->txt, (double) ctext->sz, &(ctext->ext));
 
     return;
 }
@@ -1763,3 +2113,189 @@ void show_surface_info(cairo_t *cr, GtkAllocation *allocation)
 
     return;
 }
+
+
+/* Check if the cached image is for the current data and size */
+
+int chart_cache_current(ChartCache *cc, cairo_t *cr, GtkAllocation *allocation)
+{
+    double sx, sy;
+
+    /* Allow for the output device scale (HiDPI) */
+    cairo_surface_get_device_scale (cairo_get_target (cr), &sx, &sy);
+
+    return (cc->surface != NULL && cc->surface_gen == cc->gen
+    			        && cc->width == allocation->width && cc->height == allocation->height
+    			        && cc->x_scale == sx && cc->y_scale == sy);
+}
+
+
+/* Context to draw a chart into its cached image, or NULL if the cached image is current */
+
+cairo_t * chart_cache_cr(ChartCache *cc, cairo_t *cr, GtkAllocation *allocation)
+{
+    double sx, sy;
+    cairo_t *cc_cr;
+
+    if (chart_cache_current(cc, cr, allocation))
+    	return NULL;
+
+    /* Allow for the output device scale (HiDPI) */
+    cairo_surface_get_device_scale (cairo_get_target (cr), &sx, &sy);
+
+    if (cc->surface == NULL || cc->width != allocation->width || cc->height != allocation->height
+    			    || cc->x_scale != sx || cc->y_scale != sy)
+    {
+	if (cc->surface != NULL)
+	    cairo_surface_destroy (cc->surface);
+
+	cc->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+						  (int) ceil(allocation->width * sx),
+						  (int) ceil(allocation->height * sy));
+	cairo_surface_set_device_scale (cc->surface, sx, sy);
+	cc->width = allocation->width;
+	cc->height = allocation->height;
+	cc->x_scale = sx;
+	cc->y_scale = sy;
+    }
+
+    cc_cr = cairo_create (cc->surface);
+
+    /* Clear (transparent) as the chart only draws its own parts */
+    cairo_set_operator (cc_cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint (cc_cr);
+    cairo_set_operator (cc_cr, CAIRO_OPERATOR_OVER);
+
+    /* Same font as the widget context */
+    cairo_set_font_face (cc_cr, cairo_get_font_face (cr));
+
+    cc->surface_gen = cc->gen;
+
+    return cc_cr;
+}
+
+
+/* Finish any drawing and paint the cached image */
+
+void chart_cache_paint(cairo_t *cr, ChartCache *cc, cairo_t *cc_cr)
+{
+    if (cc_cr != NULL)
+    {
+	cairo_destroy (cc_cr);
+	cairo_surface_flush (cc->surface);
+    }
+
+    if (cc->surface == NULL)
+    	return;
+
+    cairo_save (cr);
+    cairo_set_source_surface (cr, cc->surface, 0, 0);
+    cairo_paint (cr);
+    cairo_restore (cr);
+
+    return;
+}
+
+
+/* Chart data has changed */
+
+void chart_cache_inval(ChartCache *cc)
+{
+    cc->gen++;
+
+    return;
+}
+
+
+/* Free the cached image */
+
+void chart_cache_free(ChartCache *cc)
+{
+    if (cc->surface != NULL)
+	cairo_surface_destroy (cc->surface);
+
+    if (cc->rec != NULL)
+	cairo_surface_destroy (cc->rec);
+
+    cc->surface = NULL;
+    cc->rec = NULL;
+    cc->width = 0;
+    cc->height = 0;
+
+    return;
+}
+
+
+/* Text extents for a font size (this sets the size) */
+// Measured extents are kept by font face, size and text so unchanged labels are not measured
+// again on each draw. Extents are in user space, charts are drawn untransformed.
+
+void chart_text_extents(cairo_t *cr, char *txt, double sz, cairo_text_extents_t *ext)
+{
+    int n;
+    char *key;
+    char buf[256];
+    cairo_font_face_t *face;
+    cairo_text_extents_t *c_ext;
+
+    cairo_set_font_size (cr, sz);
+
+    if (txt == NULL)
+    {
+	memset(ext, 0, sizeof(cairo_text_extents_t));
+    	return;
+    }
+
+    if (ext_cache == NULL)
+	ext_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, free);
+
+    /* Key on the face (family, slant, weight for the 'toy' faces the charts use) */
+    // The key is built on the stack, it is only copied if it is added
+    face = cairo_get_font_face (cr);
+
+    if (cairo_font_face_get_type (face) == CAIRO_FONT_TYPE_TOY)
+	n = snprintf(buf, sizeof(buf), "%s|%d|%d|%0.2f|%s", cairo_toy_font_face_get_family (face),
+							    cairo_toy_font_face_get_slant (face),
+							    cairo_toy_font_face_get_weight (face),
+							    sz, txt);
+    else
+	n = snprintf(buf, sizeof(buf), "%p|%0.2f|%s", (void *) face, sz, txt);
+
+    if (n >= (int) sizeof(buf))
+    {
+	cairo_text_extents (cr, txt, ext);		// Long text is not kept
+    	return;
+    }
+
+    if ((c_ext = (cairo_text_extents_t *) g_hash_table_lookup (ext_cache, buf)) != NULL)
+    {
+	memcpy(ext, c_ext, sizeof(cairo_text_extents_t));
+    	return;
+    }
+
+    cairo_text_extents (cr, txt, ext);
+
+    /* Labels that change (eg. percentages) should not grow the cache indefinitely */
+    if (g_hash_table_size (ext_cache) >= EXT_CACHE_MAX)
+	g_hash_table_remove_all (ext_cache);
+
+    key = g_strdup (buf);
+    c_ext = (cairo_text_extents_t *) malloc(sizeof(cairo_text_extents_t));
+    memcpy(c_ext, ext, sizeof(cairo_text_extents_t));
+    g_hash_table_insert (ext_cache, key, c_ext);
+
+    return;
+}
+
+
+/* Free the text extents cache */
+
+void chart_text_cache_free()
+{
+    if (ext_cache != NULL)
+	g_hash_table_destroy (ext_cache);
+
+    ext_cache = NULL;
+
+    return;
+}
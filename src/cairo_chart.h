@@ -26,6 +26,12 @@
 **
 ** History
 **	28-Jul-2017	Initial
+**	19-Oct-2026	Cached chart image (size and data generation)
+**	19-Oct-2026	Line graph points held in arrays
+**	19-Oct-2026	Line graph decimated points (per plot width)
+**	19-Oct-2026	Line graph series
+**	19-Oct-2026	Axis step mark label and fit caches
+**	19-Oct-2026	Chart recording (worker thread) in the image cache
 **
 */
 
@@ -43,6 +49,24 @@
 #endif
 
 
+/* Rendered chart image, redrawn only when the size or data (generation) changes */
+
+typedef struct _chart_cache
+{
+    cairo_surface_t *surface;
+    int width;
+    int height;
+    double x_scale, y_scale;
+    unsigned int gen;
+    unsigned int surface_gen;
+    cairo_surface_t *rec;		// Recorded drawing (from the chart worker) to replay
+    int rec_width;
+    int rec_height;
+    unsigned int rec_gen;
+    int busy;				// Worker is recording
+} ChartCache;
+
+
 /* Chart Text */
 
 typedef struct _chart_text
@@ -67,6 +91,14 @@ typedef struct _axis
     double high_step;
     int prec;
     double x1, y1, x2, y2;
+    char **tick_txt;			// Step mark labels and extents, kept until the steps change
+    cairo_text_extents_t *tick_ext;
+    int n_ticks;
+    double tk_low, tk_high, tk_step, tk_sz;
+    int tk_prec;
+    GtkAllocation fit_alloc;		// Allocation and steps the axis points were last fitted for
+    double fit_low, fit_high, fit_step;
+    int fit_ok;
 } Axis;
 
 
@@ -136,15 +168,26 @@ typedef struct _line_graph
     CText *title;
     Axis *x_axis;
     Axis *y_axis;
-    GList *points;
-    const GdkRGBA *line_colour;
+    GList *series;
+    int n_points;			// All series
+    double min_x, max_x;		// Data bounds (all series), kept as points are added
+    double min_y, max_y;
 } LineGraph;
 
 
-/* Individual line graph points */
+/* Line graph series */
 
-typedef struct _point
+typedef struct _line_series
 {
-    double x_val;
-    double y_val;
-} Point;
+    CText *name;
+    const GdkRGBA *colour;
+    double *x_vals;			// Points are held in contiguous arrays
+    double *y_vals;
+    int n_points;
+    int max_points;
+    double *dec_x;			// Points reduced to the plot width (if there are more points)
+    double *dec_y;
+    int dec_n;
+    int dec_width;
+    int visible;
+} LineSeries;
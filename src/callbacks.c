@@ -64,14 +64,18 @@ void OnPrefPieLbl(GtkToggleButton*, gpointer);
 void OnPrefPieLgd(GtkToggleButton*, gpointer);
 void OnPrefBarLbl(GtkToggleButton*, gpointer);
 void OnPrefVersion(GtkToggleButton*, gpointer);
+void OnPrefRefMode(GtkToggleButton*, gpointer);
 void OnHistFind(GtkWidget *, gpointer);
 void OnCalendar(GtkWidget *, gpointer);
+void OnHistSeries(GtkToggleButton *, gpointer);
 int OnSetRefresh(GtkWidget*, GdkEvent *, gpointer);
 void OnRefreshTxt(GtkEditable *, gchar *, gint, gpointer, gpointer);
 void OnViewLog(GtkWidget*, gpointer);
 void OnSetNetDev(GtkWidget*, gpointer);
+void OnCapture(GtkToggleButton*, gpointer);
 gboolean OnOvExpose(GtkWidget *, cairo_t *, gpointer);
 gboolean OnHistExpose(GtkWidget *, cairo_t *, gpointer);
+gboolean OnSparkExpose(GtkWidget *, cairo_t *, gpointer);
 void OnQuit(GtkWidget*, gpointer);
 
 void OnOK(GtkWidget*, gpointer);
@@ -86,23 +90,26 @@ extern void user_login_main(IspData *, GtkWidget *);
 extern int delete_user_creds(IspData *, MainUi *);
 extern void load_history(IspData *, MainUi *m_ui);
 extern void reset_history(MainUi *);
+extern void hist_series_vis(MainUi *);
 extern int version_req_chk(IspData *, MainUi *);
 extern void log_msg(char*, char*, char*, GtkWidget*);
 extern void app_msg(char*, char*, GtkWidget*);
-extern void show_panel(GtkWidget *, MainUi *);
+extern void show_panel(GtkWidget **, MainUi *);
 extern char * log_name();
+extern char * log_segment(int);
+extern void load_log_segments(MainUi *);
 extern GtkWidget* view_file_main(char  *);
 extern int calendar_main(GtkWidget *, GtkWidget *);
 extern int write_user_prefs(GtkWidget *);
 extern int set_user_pref(char *, char *);
-extern int draw_pie_chart(cairo_t *, PieChart *, GtkAllocation *);
-extern void draw_bar_chart(cairo_t *, BarChart *, GtkAllocation *);
-extern int pie_chart_title(cairo_t *, PieChart *, GtkAllocation *, GtkAlign, GtkAlign);
-extern int bar_chart_title(cairo_t *, BarChart *, GtkAllocation *, GtkAlign, GtkAlign);
-extern void draw_line_graph(cairo_t *, LineGraph *, GtkAllocation *);
-extern int chart_title(cairo_t *, CText *, GtkAllocation *, GtkAlign, GtkAlign);
+extern int chart_expose(GtkWidget *, cairo_t *, ChartCache *, int, MainUi *);
 extern void get_net_details(MainUi *);
 extern int monitor_device(MainUi *);
+extern void stop_net_mon(MainUi *);
+extern void sched_close();
+extern int start_capture(char *, GtkWidget *);
+extern void stop_capture();
+extern void draw_sparkline(cairo_t *, GtkAllocation *, MainUi *);
 extern void show_surface_info(cairo_t *, GtkAllocation *);
 
 
@@ -143,7 +150,7 @@ void OnOverview(GtkWidget *btn, gpointer user_data)
     m_ui = (MainUi *) user_data;
 
     /* Display usage overview details */
-    show_panel(m_ui->oview_cntr, m_ui);
+    show_panel(&(m_ui->oview_cntr), m_ui);
 
     return;
 }  
@@ -160,7 +167,7 @@ void OnService(GtkWidget *btn, gpointer user_data)
     m_ui = (MainUi *) user_data;
 
     /* Display service plan details */
-    show_panel(m_ui->srv_cntr, m_ui);
+    show_panel(&(m_ui->srv_cntr), m_ui);
 
     return;
 }  
@@ -176,7 +183,8 @@ void OnMonitor(GtkWidget *btn, gpointer user_data)
     m_ui = (MainUi *) user_data;
 
     /* Display current network information */
-    show_panel(m_ui->mon_cntr, m_ui);
+    show_panel(&(m_ui->mon_cntr), m_ui);
+    load_log_segments(m_ui);
     get_net_details(m_ui);
 
     return;
@@ -195,8 +203,8 @@ void OnHistory(GtkWidget *btn, gpointer user_data)
     isp_data = g_object_get_data (G_OBJECT(m_ui->window), "isp_data");
 
     /* Display usage history */
+    show_panel(&(m_ui->hist_cntr), m_ui);
     load_history(isp_data, m_ui);
-    show_panel(m_ui->hist_cntr, m_ui);
 
     return;
 }  
@@ -212,7 +220,7 @@ void OnPref(GtkWidget *btn, gpointer user_data)
     m_ui = (MainUi *) user_data;
 
     /* Display About details */
-    show_panel(m_ui->pref_cntr, m_ui);
+    show_panel(&(m_ui->pref_cntr), m_ui);
 
     return;
 }  
@@ -231,7 +239,7 @@ void OnAbout(GtkWidget *btn, gpointer user_data)
 
     /* Display About details */
     version_req_chk(isp_data, m_ui);
-    show_panel(m_ui->about_cntr, m_ui);
+    show_panel(&(m_ui->about_cntr), m_ui);
 
     return;
 }  
@@ -396,6 +404,28 @@ void OnPrefVersion(GtkToggleButton *rad, gpointer user_data)
 }  
 
 
+/* Callback - User preference (refresh mode) toggled */
+
+void OnPrefRefMode(GtkToggleButton *rad, gpointer user_data)
+{  
+    MainUi *m_ui;
+    char *idx;
+
+    /* Get data */
+    m_ui = (MainUi *) user_data;
+
+    /* Ignore if not active */
+    if (! gtk_toggle_button_get_active(rad))
+	return;
+
+    /* Determine which radio toggled and set the preference */
+    idx = (char *) g_object_get_data (G_OBJECT(rad), "idx");
+    set_user_pref(REFRESH_MODE, idx);
+
+    return;
+}  
+
+
 /* Callback - Refined history search */
 
 void OnHistFind(GtkWidget *btn, gpointer user_data)
@@ -412,6 +442,22 @@ void OnHistFind(GtkWidget *btn, gpointer user_data)
 }
 
 
+/* Callback - History graph category (series) toggled */
+
+void OnHistSeries(GtkToggleButton *chk, gpointer user_data)
+{  
+    MainUi *m_ui;
+
+    /* Get data */
+    m_ui = (MainUi *) user_data;
+
+    /* Just a redraw */
+    hist_series_vis(m_ui);
+
+    return;
+}
+
+
 /* Callback - Refined history search */
 
 void OnCalendar(GtkWidget *btn, gpointer user_data)
@@ -529,18 +575,28 @@ void OnViewLog(GtkWidget *view_log, gpointer user_data)
 {  
     MainUi *m_ui;
     char *log_fn;
+    const gchar *seg;
 
     /* Check if already open */
     if (is_ui_reg(VIEW_FILE_UI, TRUE))
     	return;
 
-    /* Open */
-    log_fn = log_name();
+    /* Selected log segment - current log or an archive */
     m_ui = (MainUi *) user_data;
+    seg = gtk_combo_box_get_active_id (GTK_COMBO_BOX (m_ui->log_seg_cbox));
+
+    if (seg == NULL || (log_fn = log_segment(atoi(seg))) == NULL)
+    {
+    	log_msg("ERR0041", log_name(), "ERR0041", m_ui->window);
+    	return;
+    }
 
+    /* Open */
     if (view_file_main(log_fn) == NULL)
     	log_msg("ERR0041", log_fn, "ERR0041", m_ui->window);
 
+    free(log_fn);
+
     return;
 }  
 
@@ -561,54 +617,48 @@ void OnSetNetDev(GtkWidget *cbx, gpointer user_data)
 }  
 
 
-/* Callback - Cairo charts displaying usage information */
+/* Callback - Start or stop packet capture (top talkers) on the selected device */
 
-gboolean OnOvExpose(GtkWidget *widget, cairo_t *cr, gpointer user_data)
+void OnCapture(GtkToggleButton *chk, gpointer user_data)
 {  
     MainUi *m_ui;
-    GtkAllocation allocation, pseudo_alloc;
 
-    /* Get user data, the drawing area and adjust if necessary */
     m_ui = (MainUi *) user_data;
 
-    GdkWindow *window = gtk_widget_get_window (widget);
-    gtk_widget_get_allocation (widget, &allocation);
-    memcpy(&pseudo_alloc, &allocation, sizeof(allocation));
+    if (gtk_toggle_button_get_active(chk) == FALSE)
+    {
+	stop_capture();
+	return;
+    }
 
-    /* Drawing area space needs to be split up for a pie chart and a bar chart */
-    pseudo_alloc.width = (double) pseudo_alloc.width * 0.7;
-    pseudo_alloc.x = 0;
-    pseudo_alloc.y = 0;
+    if (start_capture(m_ui->mon_dev, m_ui->window) == FALSE)
+	gtk_toggle_button_set_active(chk, FALSE);
 
-    /* Do title (this does nothing if there is no title) */
-    pie_chart_title(cr, m_ui->pie_chart, &pseudo_alloc, GTK_ALIGN_CENTER, GTK_ALIGN_START);
+    return;
+}  
 
-    /* Need to adjust y coordinate - if we used GTK_ALIGN_END (v_align) we would adjust the height */
-    if (m_ui->pie_chart->title != NULL)
-	pseudo_alloc.y += m_ui->pie_chart->title->ext.height;		// GTK_ALIGN_START
-	//pseudo_alloc.height -= m_ui->pie_chart->title.ext.height;	// GTK_ALIGN_END
 
-    /* Draw the pie chart */
-    draw_pie_chart(cr, m_ui->pie_chart, &pseudo_alloc);
+/* Callback - Cairo charts displaying usage information */
 
-    /* Do title (this does nothing if there is no title) */
-    pseudo_alloc.x = pseudo_alloc.width;
-    pseudo_alloc.y = 0;
-    pseudo_alloc.width = allocation.width - pseudo_alloc.x;
-    bar_chart_title(cr, m_ui->bar_chart, &pseudo_alloc, GTK_ALIGN_CENTER, GTK_ALIGN_START);
+gboolean OnOvExpose(GtkWidget *widget, cairo_t *cr, gpointer user_data)
+{  
+    MainUi *m_ui;
+    GtkAllocation allocation;
 
-    /* Need to adjust y coordinate - if we used GTK_ALIGN_END (v_align) we would adjust the height */
-    if (m_ui->bar_chart->title != NULL)
-	pseudo_alloc.y += m_ui->bar_chart->title->ext.height;		// GTK_ALIGN_START
-	//pseudo_alloc.height -= m_ui->bar_chart->title.ext.height;	// GTK_ALIGN_END
+    /* Get user data and the drawing area */
+    m_ui = (MainUi *) user_data;
 
-    /* Draw the bar chart */
-    draw_bar_chart(cr, m_ui->bar_chart, &pseudo_alloc);
+    GdkWindow *window = gtk_widget_get_window (widget);
+    gtk_widget_get_allocation (widget, &allocation);
+
+    if (m_ui->pie_chart == NULL || m_ui->bar_chart == NULL)
+    	return FALSE;
 
 //printf("%s OnExpose 9\n", debug_hdr); fflush(stdout);
     show_surface_info(cr, &allocation);	// Info or Debug
 
-    return TRUE;
+    /* The charts are laid out and drawn off this thread when the size or data change */
+    return chart_expose(widget, cr, &(m_ui->ov_cache), CHART_OVERVIEW, m_ui);
 }
 
 
@@ -617,28 +667,36 @@ gboolean OnOvExpose(GtkWidget *widget, cairo_t *cr, gpointer user_data)
 gboolean OnHistExpose(GtkWidget *widget, cairo_t *cr, gpointer user_data)
 {  
     MainUi *m_ui;
-    GtkAllocation allocation, pseudo_alloc;
+    GtkAllocation allocation;
 
-    /* Get user data, the drawing area and adjust if necessary */
+    /* Get user data and the drawing area */
     m_ui = (MainUi *) user_data;
 
-    // Drawing area does not require adjustment for history, 
-    // but use a 'pseudo' allocation anyway to keep to a standard approach
     GdkWindow *window = gtk_widget_get_window (widget);
     gtk_widget_get_allocation (widget, &allocation);
-    memcpy(&pseudo_alloc, &allocation, sizeof(allocation));
+
+    if (m_ui->hist_usg_graph == NULL)
+    	return FALSE;
 
 //printf("%s OnHistExpose 1\n", debug_hdr); fflush(stdout);
     show_surface_info(cr, &allocation);	// Info or Debug
 
-    pseudo_alloc.x = 0;
-    pseudo_alloc.y = 0;
+    /* The graph is laid out and drawn off this thread when the size or data change */
+    return chart_expose(widget, cr, &(m_ui->hist_cache), CHART_HISTORY, m_ui);
+}
 
-    /* Do title (this does nothing if there is no title) */
-    chart_title(cr, m_ui->hist_usg_graph->title, &pseudo_alloc, GTK_ALIGN_CENTER, GTK_ALIGN_START);
 
-    /* Draw the history graph */
-    draw_line_graph(cr, m_ui->hist_usg_graph, &pseudo_alloc);
+/* Callback - Sparkline of recent network speeds for the selected device */
+
+gboolean OnSparkExpose(GtkWidget *widget, cairo_t *cr, gpointer user_data)
+{  
+    MainUi *m_ui;
+    GtkAllocation allocation;
+
+    m_ui = (MainUi *) user_data;
+    gtk_widget_get_allocation (widget, &allocation);
+
+    draw_sparkline(cr, &allocation, m_ui);
 
     return TRUE;
 }
@@ -650,30 +708,17 @@ gboolean OnHistExpose(GtkWidget *widget, cairo_t *cr, gpointer user_data)
 
 void OnQuit(GtkWidget *w, gpointer user_data)
 {  
-    int r;
-    void *res;
     GtkWidget *window;
     MainUi *m_ui;
-    RefreshTmr *ref_tmr;
 
     /* Initial */
     window = (GtkWidget *) user_data;
     m_ui = g_object_get_data (G_OBJECT(window), "ui");
 
-    /* Clean up threads */
-    ref_tmr = &(m_ui->RefTmr);
-
-    if (ref_tmr->tmr_id != 0)
-    {
-	if ((r = pthread_cancel(m_ui->RefTmr.refresh_tid)) == 0)
-	    pthread_join(m_ui->RefTmr.refresh_tid, &res);
-
-	g_source_remove (m_ui->RefTmr.tmr_id);
-    }
-
-    if (m_ui->net_speed_tid != 0)
-	if ((r = pthread_cancel(m_ui->net_speed_tid)) == 0)
-	    pthread_join(m_ui->net_speed_tid, &res);
+    /* Clean up jobs and threads */
+    sched_close();
+    stop_net_mon(m_ui);
+    stop_capture();
 
     /* Close any open windows */
     close_open_ui();
@@ -0,0 +1,326 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:
+**  Optional packet capture on the selected device to find the top talkers.
+**  libpcap (on Linux a TPACKET_V3 memory mapped ring) with a kernel BPF filter and a
+**  snapshot length that only takes the headers. A capture thread waits on the capture
+**  descriptor and adds each batch of packets to a flow table by remote host and port.
+**  Capture needs root or the CAP_NET_RAW capability.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Defines */
+
+#define CAP_FILTER "ip or ip6"
+#define CAP_BUF_SZ (4 * 1024 * 1024)
+#define CAP_WAIT_MS 250
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <pcap.h>
+#include <gtk/gtk.h>
+#include <net_stats.h>
+#include <defs.h>
+
+
+/* Prototypes */
+
+int start_capture(char *, GtkWidget *);
+void stop_capture();
+int capture_active();
+int capture_top(FlowEntry *, int);
+void * capture_thread(void *);
+void capture_pkt(u_char *, const struct pcap_pkthdr *, const u_char *);
+int cap_error(pcap_t *, char *, int, GtkWidget *);
+void set_local_addrs(FlowTable *);
+
+extern FlowTable * flow_table_new(unsigned int);
+extern void flow_table_free(FlowTable *);
+extern void flow_set_local(FlowTable *, FlowKey *, int);
+extern int flow_account(FlowTable *, int, const unsigned char *, unsigned int, unsigned int);
+extern int flow_top(FlowTable *, FlowEntry *, int);
+extern void log_msg(char*, char*, char*, GtkWidget*);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-capture.c ";
+static pcap_t *cap_p = NULL;
+static pthread_t cap_tid = 0;
+static pthread_mutex_t cap_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FlowTable *cap_ft = NULL;
+static int cap_dlt;
+static int cap_stop;
+static int cap_thr;
+
+
+
+/* Start capturing on a device. Any current capture is stopped first */
+
+int start_capture(char *dev, GtkWidget *window)
+{
+    int r;
+    char errbuf[PCAP_ERRBUF_SIZE];
+    struct bpf_program fp;
+
+    stop_capture();
+
+    /* Set up (the options must be set before activation) */
+    if ((cap_p = pcap_create(dev, errbuf)) == NULL)
+    {
+	sprintf(app_msg_extra, "%s", errbuf);
+	log_msg("ERR0055", dev, "ERR0055", window);
+	return FALSE;
+    }
+
+    pcap_set_snaplen(cap_p, CAP_SNAPLEN);
+    pcap_set_promisc(cap_p, FALSE);
+    pcap_set_timeout(cap_p, CAP_WAIT_MS);
+    pcap_set_buffer_size(cap_p, CAP_BUF_SZ);
+
+    if ((r = pcap_activate(cap_p)) < 0)
+	return cap_error(cap_p, dev, r, window);
+
+    /* Filter in the kernel */
+    if (pcap_compile(cap_p, &fp, CAP_FILTER, 1, PCAP_NETMASK_UNKNOWN) < 0)
+	return cap_error(cap_p, dev, 0, window);
+
+    if (pcap_setfilter(cap_p, &fp) < 0)
+    {
+	pcap_freecode(&fp);
+	return cap_error(cap_p, dev, 0, window);
+    }
+
+    pcap_freecode(&fp);
+
+    if (pcap_setnonblock(cap_p, 1, errbuf) < 0 || pcap_get_selectable_fd(cap_p) < 0)
+	return cap_error(cap_p, dev, 0, window);
+
+    cap_dlt = pcap_datalink(cap_p);
+
+    /* Flows */
+    cap_ft = flow_table_new(1024);
+    set_local_addrs(cap_ft);
+
+    /* Capture thread */
+    cap_stop = FALSE;
+
+    if ((r = pthread_create(&cap_tid, NULL, &capture_thread, NULL)) != 0)
+    {
+	sprintf(app_msg_extra, "Error: %s", strerror(r));
+	log_msg("ERR0055", dev, "ERR0055", window);
+	cap_tid = 0;
+	stop_capture();
+	return FALSE;
+    }
+
+    cap_thr = TRUE;
+
+    return TRUE;
+}
+
+
+/* Stop the capture thread and free */
+
+void stop_capture()
+{
+    if (cap_thr == TRUE)
+    {
+	cap_stop = TRUE;
+	pthread_join(cap_tid, NULL);
+	cap_tid = 0;
+	cap_thr = FALSE;
+    }
+
+    if (cap_p != NULL)
+    {
+	pcap_close(cap_p);
+	cap_p = NULL;
+    }
+
+    pthread_mutex_lock(&cap_mutex);
+    flow_table_free(cap_ft);
+    cap_ft = NULL;
+    pthread_mutex_unlock(&cap_mutex);
+
+    return;
+}
+
+
+/* Capture is running */
+
+int capture_active()
+{
+    return cap_thr;
+}
+
+
+/* Copy of the top flows (main loop) */
+
+int capture_top(FlowEntry *top, int n)
+{
+    int cnt;
+
+    pthread_mutex_lock(&cap_mutex);
+    cnt = (cap_ft == NULL) ? 0 : flow_top(cap_ft, top, n);
+    pthread_mutex_unlock(&cap_mutex);
+
+    return cnt;
+}
+
+
+/*
+** Capture thread. Wait for the descriptor to be ready (so the stop flag is seen at least
+** every CAP_WAIT_MS) then take everything available in one batch under the table lock.
+*/
+
+void * capture_thread(void *arg)
+{
+    int fd;
+    struct pollfd pfd;
+
+    fd = pcap_get_selectable_fd(cap_p);
+
+    while(cap_stop == FALSE)
+    {
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+
+	if (poll(&pfd, 1, CAP_WAIT_MS) < 0)
+	{
+	    if (errno == EINTR)
+	    	continue;
+
+	    break;
+	}
+
+	pthread_mutex_lock(&cap_mutex);
+
+	if (pcap_dispatch(cap_p, -1, capture_pkt, NULL) < 0)
+	{
+	    pthread_mutex_unlock(&cap_mutex);
+	    break;
+	}
+
+	pthread_mutex_unlock(&cap_mutex);
+    }
+
+    pthread_exit(NULL);
+}
+
+
+/* Packet callback (capture thread, table lock held) */
+
+void capture_pkt(u_char *user, const struct pcap_pkthdr *hdr, const u_char *pkt)
+{
+    flow_account(cap_ft, cap_dlt, pkt, hdr->caplen, hdr->len);
+
+    return;
+}
+
+
+/* Report a capture set up error and close */
+
+int cap_error(pcap_t *p, char *dev, int r, GtkWidget *window)
+{
+    if (r == PCAP_ERROR_PERM_DENIED)
+	sprintf(app_msg_extra, "Permission denied (root or CAP_NET_RAW is required)");
+    else
+	snprintf(app_msg_extra, sizeof(app_msg_extra), "%s", pcap_geterr(p));
+
+    log_msg("ERR0055", dev, "ERR0055", window);
+    pcap_close(p);
+    cap_p = NULL;
+
+    return FALSE;
+}
+
+
+/* Addresses of this machine (to tell sent from received) */
+
+void set_local_addrs(FlowTable *ft)
+{
+    int n, max;
+    struct ifaddrs *ifa_list, *ifa;
+    FlowKey *addr;
+
+    if (getifaddrs(&ifa_list) < 0)
+    	return;
+
+    n = 0;
+    max = 16;
+    addr = (FlowKey *) calloc(max, sizeof(FlowKey));
+
+    for(ifa = ifa_list; ifa != NULL; ifa = ifa->ifa_next)
+    {
+	if (ifa->ifa_addr == NULL)
+	    continue;
+
+	if (ifa->ifa_addr->sa_family != AF_INET && ifa->ifa_addr->sa_family != AF_INET6)
+	    continue;
+
+	if (n >= max)
+	{
+	    max *= 2;
+	    addr = (FlowKey *) realloc(addr, max * sizeof(FlowKey));
+	}
+
+	memset(&addr[n], 0, sizeof(FlowKey));
+
+	if (ifa->ifa_addr->sa_family == AF_INET)
+	{
+	    memcpy(addr[n].addr, &(((struct sockaddr_in *) ifa->ifa_addr)->sin_addr), 4);
+	    addr[n].family = 4;
+	}
+	else
+	{
+	    memcpy(addr[n].addr, &(((struct sockaddr_in6 *) ifa->ifa_addr)->sin6_addr), 16);
+	    addr[n].family = 6;
+	}
+
+	n++;
+    }
+
+    freeifaddrs(ifa_list);
+    flow_set_local(ft, addr, n);
+    free(addr);
+
+    return;
+}
@@ -0,0 +1,341 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+
+/*
+** Description:
+**  Chart rendering benchmark - draws the overview (pie and bar) charts and the history line
+**  graph onto offscreen image surfaces at several sizes and data volumes, using the same
+**  drawing code as the display. No display is needed. For each case the first (cold) render,
+**  with an empty text extents cache, is shown separately from the average of the rest.
+**  Optionally each case is also written out (PNG, SVG and PDF) for visual comparison.
+**
+**  Usage:  chart_bench [-r repeat] [-o output_prefix]
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Defines */
+
+#define MAIN_UI
+#define N_SIZES 4
+#define N_SERIES 5
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <gtk/gtk.h>
+#include <cairo/cairo.h>
+#include <cairo_chart.h>
+#include <defs.h>
+
+
+/* Types */
+
+
+/* Prototypes */
+
+void make_overview(int, PieChart **, BarChart **);
+LineGraph * make_history(int);
+void bench_case(char *, int, int, int, double, PieChart *, BarChart *, LineGraph *, char *);
+double mono_secs();
+void usage();
+
+extern PieChart * pie_chart_create(char *, double, int, const GdkRGBA *, int, int);
+extern int pie_slice_create(PieChart *, char *, double, const GdkRGBA *, const GdkRGBA *, int);
+extern BarChart * bar_chart_create(char *, const GdkRGBA *, int, int, Axis *, Axis *);
+extern Bar * bar_create(BarChart *);
+extern int bar_segment_create(BarChart *, Bar *, char *, const GdkRGBA *, const GdkRGBA *, int, double);
+extern void free_pie_chart(PieChart *);
+extern void free_bar_chart(BarChart *);
+extern LineGraph * line_graph_create(char *, const GdkRGBA *, int, 
+				     char *, double, double,
+				     const GdkRGBA *, int, const GdkRGBA *, int,
+				     char *, double, double,
+				     const GdkRGBA *, int, const GdkRGBA *, int);
+extern LineSeries * line_graph_add_series(LineGraph *, char *, const GdkRGBA *);
+extern void line_graph_add_point(LineGraph *, LineSeries *, double, double);
+extern void set_line_graph_bounds(LineGraph *);
+extern void free_line_graph(LineGraph *);
+extern void chart_text_cache_free();
+extern void draw_overview(cairo_t *, PieChart *, BarChart *, GtkAllocation *);
+extern void draw_history(cairo_t *, LineGraph *, GtkAllocation *);
+extern int chart_render_file(char *, int, int, PieChart *, BarChart *, LineGraph *);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-chart_bench.c ";
+static const int sizes[N_SIZES][2] = { {250, 160}, {600, 400}, {1200, 800}, {1920, 1080} };
+static const int slice_counts[] = { 2, 8 };
+static const int day_counts[] = { 30, 365, 3650, 36500 };
+
+
+
+/* Run each chart type at each size and data volume */
+
+int main(int argc, char *argv[])
+{
+    int c, i, j, repeat;
+    double t0, build;
+    char *prefix;
+    char nm[40];
+    PieChart *pc;
+    BarChart *bc;
+    LineGraph *lg;
+
+    repeat = 20;
+    prefix = NULL;
+
+    while((c = getopt(argc, argv, "r:o:h")) != -1)
+    {
+	switch(c)
+	{
+	    case 'r':
+		if ((repeat = atoi(optarg)) < 1)
+		    repeat = 1;
+		break;
+
+	    case 'o':
+		prefix = optarg;
+		break;
+
+	    default:
+		usage();
+		return 1;
+	}
+    }
+
+    printf("%-24s %11s %10s %10s %10s\n", "Chart", "Size", "Build ms", "Cold ms", "Avg ms");
+
+    /* Overview */
+    for(i = 0; i < (int) (sizeof(slice_counts) / sizeof(int)); i++)
+    {
+	t0 = mono_secs();
+	make_overview(slice_counts[i], &pc, &bc);
+	build = mono_secs() - t0;
+	sprintf(nm, "overview_%dslices", slice_counts[i]);
+
+	for(j = 0; j < N_SIZES; j++)
+	    bench_case(nm, sizes[j][0], sizes[j][1], repeat, build, pc, bc, NULL, prefix);
+
+	free_pie_chart(pc);
+	free_bar_chart(bc);
+    }
+
+    /* History */
+    for(i = 0; i < (int) (sizeof(day_counts) / sizeof(int)); i++)
+    {
+	for(j = 0; j < N_SIZES; j++)
+	{
+	    t0 = mono_secs();
+	    lg = make_history(day_counts[i]);
+	    build = mono_secs() - t0;
+	    sprintf(nm, "history_%ddays", day_counts[i]);
+	    bench_case(nm, sizes[j][0], sizes[j][1], repeat, build, NULL, NULL, lg, prefix);
+	    free_line_graph(lg);
+	}
+    }
+
+    chart_text_cache_free();
+
+    return 0;
+}
+
+
+/* Overview charts as built for the display, with 'n' pie slices */
+
+void make_overview(int n, PieChart **pc, BarChart **bc)
+{
+    int i;
+    char s[20];
+    Bar *bar;
+    const GdkRGBA *colours[] = { &MID_YELLOW, &LIGHT_BLUE, &LIGHT_RED, &DARK_GREEN, &MID_ORANGE, &MID_PURPLE };
+
+    *pc = pie_chart_create("Quota Distribution", 0, TRUE, &DARK_BLUE, 9, TRUE);
+
+    for(i = 0; i < n; i++)
+    {
+	sprintf(s, "Slice %d", i + 1);
+	pie_slice_create(*pc, s, (double) (i + 1) * 1000000.0, colours[i % 6], &DARK_MAROON, 10);
+    }
+
+    *bc = bar_chart_create("Quota Rollover", &DARK_BLUE, 9, TRUE, NULL, NULL);
+    bar = bar_create(*bc);
+    bar_segment_create(*bc, bar, NULL, &MID_YELLOW, &DARK_MAROON, 9, 12.5);
+    bar_segment_create(*bc, bar, NULL, &WHITE, &DARK_MAROON, 9, 17.5);
+
+    return;
+}
+
+
+/* History graph as built for the display (all categories), 'days' of synthetic usage */
+
+LineGraph * make_history(int days)
+{
+    int i, j;
+    double x_step, y_step, v;
+    LineGraph *lg;
+    LineSeries *ls[N_SERIES];
+    const char *cats[] = { "Total", "Metered up", "Metered down", "Unmetered up", "Unmetered down" };
+    const GdkRGBA *colours[] = { &LIGHT_RED, &DARK_BLUE, &DARK_GREEN, &MID_ORANGE, &MID_PURPLE };
+
+    x_step = ceil((double) days / 6.0);
+    y_step = 200.0;
+
+    lg = line_graph_create(NULL, NULL, 0,
+			   "Days", x_step, 0,
+			   &DARK_MAROON, 10, &DARK_BLUE, 8,
+			   "MB", y_step, 0,
+			   &DARK_MAROON, 10, &DARK_BLUE, 8);
+
+    for(j = 0; j < N_SERIES; j++)
+    	ls[j] = line_graph_add_series(lg, (char *) cats[j], colours[j]);
+
+    /* Daily usage with a weekly pattern and some noise, the total is the sum of the others */
+    srand(days);
+
+    for(i = 0; i < days; i++)
+    {
+	v = 0;
+
+	for(j = 1; j < N_SERIES; j++)
+	{
+	    line_graph_add_point(lg, ls[j], (double) i,
+				 (200.0 / j) * (1.0 + 0.5 * sin(i * 2.0 * M_PI / 7.0)) + (rand() % 50));
+	    v += ls[j]->y_vals[i];
+	}
+
+	line_graph_add_point(lg, ls[0], (double) i, v);
+    }
+
+    set_line_graph_bounds(lg);
+
+    return lg;
+}
+
+
+/* Time the renders of one chart at one size (and write it out if required) */
+
+void bench_case(char *nm, int w, int h, int repeat, double build, PieChart *pc, BarChart *bc, LineGraph *lg, char *prefix)
+{
+    int r;
+    double t0, cold, secs;
+    char sz[20];
+    char *fn;
+    const char *ftyp[] = { "png", "svg", "pdf" };
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    GtkAllocation allocation;
+
+    allocation.x = 0;
+    allocation.y = 0;
+    allocation.width = w;
+    allocation.height = h;
+    surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, w, h);
+
+    /* Cold - nothing measured yet */
+    chart_text_cache_free();
+    cold = 0;
+    secs = 0;
+
+    for(r = 0; r <= repeat; r++)
+    {
+	cr = cairo_create (surface);
+	cairo_set_source_rgba (cr, 1.0, 1.0, 1.0, 1.0);
+	cairo_paint (cr);
+
+	t0 = mono_secs();
+
+	if (lg != NULL)
+	    draw_history(cr, lg, &allocation);
+	else
+	    draw_overview(cr, pc, bc, &allocation);
+
+	cairo_surface_flush (surface);
+
+	if (r == 0)
+	    cold = mono_secs() - t0;
+	else
+	    secs += mono_secs() - t0;
+
+	cairo_destroy (cr);
+    }
+
+    cairo_surface_destroy (surface);
+
+    sprintf(sz, "%dx%d", w, h);
+    printf("%-24s %11s %10.3f %10.3f %10.3f\n", nm, sz, build * 1000.0, cold * 1000.0, secs * 1000.0 / repeat);
+
+    /* Output files */
+    if (prefix == NULL)
+    	return;
+
+    fn = (char *) malloc(strlen(prefix) + strlen(nm) + 30);
+
+    for(r = 0; r < 3; r++)
+    {
+	sprintf(fn, "%s%s_%s.%s", prefix, nm, sz, ftyp[r]);
+
+	if (chart_render_file(fn, w, h, pc, bc, lg) == FALSE)
+	    fprintf(stderr, "Failed to write %s\n", fn);
+    }
+
+    free(fn);
+
+    return;
+}
+
+
+/* Monotonic time (seconds) */
+
+double mono_secs()
+{
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+
+    return (double) tp.tv_sec + (double) tp.tv_nsec / 1000000000.0;
+}
+
+
+/* Usage */
+
+void usage()
+{
+    fprintf(stderr, "Usage: chart_bench [-r repeat] [-o output_prefix]\n");
+    fprintf(stderr, "  Times the overview and history charts at several sizes and data volumes.\n");
+    fprintf(stderr, "  With -o each case is also written as PNG, SVG and PDF.\n");
+
+    return;
+}
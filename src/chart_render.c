@@ -0,0 +1,199 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+** Description:	Chart drawing common to the display and files (no display required).
+**		The overview (pie and bar) and history (line graph) layouts are drawn
+**		here for the 'draw' callbacks and may also be rendered to a PNG, SVG or
+**		PDF file, for reports or comparing output between changes.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Defines */
+
+
+/* Includes */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <cairo/cairo.h>
+#include <cairo/cairo-svg.h>
+#include <cairo/cairo-pdf.h>
+#include <cairo_chart.h>
+#include <defs.h>
+
+
+/* Types */
+
+
+/* Prototypes */
+
+void draw_overview(cairo_t *, PieChart *, BarChart *, GtkAllocation *);
+void draw_history(cairo_t *, LineGraph *, GtkAllocation *);
+int chart_render_file(char *, int, int, PieChart *, BarChart *, LineGraph *);
+
+extern int draw_pie_chart(cairo_t *, PieChart *, GtkAllocation *);
+extern int draw_bar_chart(cairo_t *, BarChart *, GtkAllocation *);
+extern int pie_chart_title(cairo_t *, PieChart *, GtkAllocation *, GtkAlign, GtkAlign);
+extern int bar_chart_title(cairo_t *, BarChart *, GtkAllocation *, GtkAlign, GtkAlign);
+extern void draw_line_graph(cairo_t *, LineGraph *, GtkAllocation *);
+extern int chart_title(cairo_t *, CText *, GtkAllocation *, GtkAlign, GtkAlign);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-chart_render.c ";
+
+
+/* Overview charts - the area is split up for a pie chart and a bar chart */
+
+void draw_overview(cairo_t *cr, PieChart *pie_chart, BarChart *bar_chart, GtkAllocation *allocation)
+{  
+    GtkAllocation pseudo_alloc;
+
+    memcpy(&pseudo_alloc, allocation, sizeof(GtkAllocation));
+    pseudo_alloc.width = (double) pseudo_alloc.width * 0.7;
+    pseudo_alloc.x = 0;
+    pseudo_alloc.y = 0;
+
+    /* Do title (this does nothing if there is no title) */
+    pie_chart_title(cr, pie_chart, &pseudo_alloc, GTK_ALIGN_CENTER, GTK_ALIGN_START);
+
+    /* Need to adjust y coordinate - if we used GTK_ALIGN_END (v_align) we would adjust the height */
+    if (pie_chart->title != NULL)
+	pseudo_alloc.y += pie_chart->title->ext.height;		// GTK_ALIGN_START
+	//pseudo_alloc.height -= pie_chart->title.ext.height;	// GTK_ALIGN_END
+
+    /* Draw the pie chart */
+    draw_pie_chart(cr, pie_chart, &pseudo_alloc);
+
+    /* Do title (this does nothing if there is no title) */
+    pseudo_alloc.x = pseudo_alloc.width;
+    pseudo_alloc.y = 0;
+    pseudo_alloc.width = allocation->width - pseudo_alloc.x;
+    bar_chart_title(cr, bar_chart, &pseudo_alloc, GTK_ALIGN_CENTER, GTK_ALIGN_START);
+
+    /* Need to adjust y coordinate - if we used GTK_ALIGN_END (v_align) we would adjust the height */
+    if (bar_chart->title != NULL)
+	pseudo_alloc.y += bar_chart->title->ext.height;		// GTK_ALIGN_START
+	//pseudo_alloc.height -= bar_chart->title.ext.height;	// GTK_ALIGN_END
+
+    /* Draw the bar chart */
+    draw_bar_chart(cr, bar_chart, &pseudo_alloc);
+
+    return;
+}
+
+
+/* History line graph */
+
+void draw_history(cairo_t *cr, LineGraph *lg, GtkAllocation *allocation)
+{  
+    GtkAllocation pseudo_alloc;
+
+    // Drawing area does not require adjustment for history, 
+    // but use a 'pseudo' allocation anyway to keep to a standard approach
+    memcpy(&pseudo_alloc, allocation, sizeof(GtkAllocation));
+    pseudo_alloc.x = 0;
+    pseudo_alloc.y = 0;
+
+    /* Do title (this does nothing if there is no title) */
+    chart_title(cr, lg->title, &pseudo_alloc, GTK_ALIGN_CENTER, GTK_ALIGN_START);
+
+    /* Draw the history graph */
+    draw_line_graph(cr, lg, &pseudo_alloc);
+
+    return;
+}
+
+
+/* Render the overview (pie and bar charts) or a line graph to a file */
+
+// The file type is taken from the name: .svg, .pdf, otherwise PNG. Sizes are in points 
+// for SVG and PDF, pixels for PNG.
+
+int chart_render_file(char *fn, int w, int h, PieChart *pie_chart, BarChart *bar_chart, LineGraph *lg)
+{  
+    int r;
+    char *ext;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    GtkAllocation allocation;
+
+    if ((pie_chart == NULL || bar_chart == NULL) && lg == NULL)
+    	return FALSE;
+
+    if ((ext = strrchr(fn, '.')) == NULL)
+    	ext = "";
+
+    if (strcasecmp(ext, ".svg") == 0)
+	surface = cairo_svg_surface_create (fn, (double) w, (double) h);
+    else if (strcasecmp(ext, ".pdf") == 0)
+	surface = cairo_pdf_surface_create (fn, (double) w, (double) h);
+    else
+	surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, w, h);
+
+    if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+    {
+	cairo_surface_destroy (surface);
+    	return FALSE;
+    }
+
+    /* Charts only draw their own parts, so give them a background */
+    cr = cairo_create (surface);
+    cairo_set_source_rgba (cr, WHITE.red, WHITE.green, WHITE.blue, WHITE.alpha);
+    cairo_paint (cr);
+
+    allocation.x = 0;
+    allocation.y = 0;
+    allocation.width = w;
+    allocation.height = h;
+
+    if (lg != NULL)
+	draw_history(cr, lg, &allocation);
+    else
+	draw_overview(cr, pie_chart, bar_chart, &allocation);
+
+    cairo_destroy (cr);
+    cairo_surface_flush (surface);
+    r = TRUE;
+
+    if (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE)
+	r = (cairo_surface_write_to_png (surface, fn) == CAIRO_STATUS_SUCCESS);
+    else
+	cairo_surface_finish (surface);
+
+    if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+    	r = FALSE;
+
+    cairo_surface_destroy (surface);
+
+    return r;
+}
@@ -0,0 +1,274 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+** Description:	Chart layout and drawing off the main (GTK) thread.
+**		When a chart's data or size changes, a worker thread draws it onto a
+**		cairo recording surface - an immutable list of the paths and positioned
+**		text. The 'draw' callback only replays the recording into the cached
+**		image, so a slow chart (eg. a long history) does not hold up the UI.
+**		The last image is shown until the new recording is ready.
+**		Chart objects (and the text extents cache they use) are only changed
+**		under the chart lock.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Defines */
+
+
+/* Includes */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <cairo/cairo.h>
+#include <main.h>
+#include <defs.h>
+
+
+/* Types */
+
+typedef struct _chart_job
+{
+    int typ;
+    ChartCache *cc;
+    GtkWidget *widget;
+    MainUi *m_ui;
+    GtkAllocation allocation;
+    unsigned int gen;
+    cairo_font_face_t *face;
+    cairo_surface_t *rec;
+} ChartJob;
+
+
+/* Prototypes */
+
+int chart_expose(GtkWidget *, cairo_t *, ChartCache *, int, MainUi *);
+void chart_lock();
+void chart_unlock();
+void * chart_job_thread(void *);
+gboolean chart_job_done(gpointer);
+void draw_chart_typ(cairo_t *, int, MainUi *, GtkAllocation *);
+
+extern int chart_cache_current(ChartCache *, cairo_t *, GtkAllocation *);
+extern cairo_t * chart_cache_cr(ChartCache *, cairo_t *, GtkAllocation *);
+extern void chart_cache_paint(cairo_t *, ChartCache *, cairo_t *);
+extern void draw_overview(cairo_t *, PieChart *, BarChart *, GtkAllocation *);
+extern void draw_history(cairo_t *, LineGraph *, GtkAllocation *);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-chart_worker.c ";
+static pthread_mutex_t chart_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* Paint a chart, starting a worker to record it if the data or size have changed */
+
+int chart_expose(GtkWidget *widget, cairo_t *cr, ChartCache *cc, int typ, MainUi *m_ui)
+{
+    int r;
+    pthread_t tid;
+    cairo_t *ccr;
+    ChartJob *job;
+    GtkAllocation allocation;
+
+    gtk_widget_get_allocation (widget, &allocation);
+
+    /* Current image */
+    if (chart_cache_current(cc, cr, &allocation))
+    {
+	chart_cache_paint(cr, cc, NULL);
+	return TRUE;
+    }
+
+    /* A recording is ready, replay it into the image */
+    if (cc->rec != NULL && cc->rec_gen == cc->gen
+    		        && cc->rec_width == allocation.width && cc->rec_height == allocation.height)
+    {
+	ccr = chart_cache_cr(cc, cr, &allocation);
+	cairo_set_source_surface (ccr, cc->rec, 0, 0);
+	cairo_paint (ccr);
+	chart_cache_paint(cr, cc, ccr);
+	return TRUE;
+    }
+
+    /* Show the last image (if any) while a new recording is made */
+    chart_cache_paint(cr, cc, NULL);
+
+    if (cc->busy == TRUE)
+    	return TRUE;
+
+    job = (ChartJob *) malloc(sizeof(ChartJob));
+    memset(job, 0, sizeof(ChartJob));
+    job->typ = typ;
+    job->cc = cc;
+    job->widget = widget;
+    job->m_ui = m_ui;
+    job->gen = cc->gen;
+    job->face = cairo_font_face_reference (cairo_get_font_face (cr));
+    memcpy(&(job->allocation), &allocation, sizeof(GtkAllocation));
+
+    g_object_ref (widget);
+
+    if ((r = pthread_create(&tid, NULL, &chart_job_thread, (void *) job)) != 0)
+    {
+	/* Draw here instead */
+	g_object_unref (widget);
+	cairo_font_face_destroy (job->face);
+	free(job);
+
+	if ((ccr = chart_cache_cr(cc, cr, &allocation)) != NULL)
+	{
+	    chart_lock();
+	    draw_chart_typ(ccr, typ, m_ui, &allocation);
+	    chart_unlock();
+	}
+
+	chart_cache_paint(cr, cc, ccr);
+	return TRUE;
+    }
+
+    pthread_detach(tid);
+    cc->busy = TRUE;
+
+    return TRUE;
+}
+
+
+/* Record a chart (worker thread) */
+
+void * chart_job_thread(void *arg)
+{
+    cairo_t *cr;
+    cairo_rectangle_t ext;
+    ChartJob *job;
+
+    job = (ChartJob *) arg;
+
+    ext.x = 0;
+    ext.y = 0;
+    ext.width = job->allocation.width;
+    ext.height = job->allocation.height;
+
+    job->rec = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, &ext);
+    cr = cairo_create (job->rec);
+    cairo_set_font_face (cr, job->face);
+
+    /* Chart objects may not change while in use */
+    chart_lock();
+    draw_chart_typ(cr, job->typ, job->m_ui, &(job->allocation));
+    chart_unlock();
+
+    cairo_destroy (cr);
+
+    /* Back to the main thread */
+    g_idle_add (chart_job_done, job);
+
+    pthread_exit(NULL);
+}
+
+
+/* Recording finished (main thread) - keep it if it is still wanted and redraw */
+
+gboolean chart_job_done(gpointer user_data)
+{
+    ChartJob *job;
+    ChartCache *cc;
+
+    job = (ChartJob *) user_data;
+    cc = job->cc;
+    cc->busy = FALSE;
+
+    if (job->gen == cc->gen)
+    {
+	if (cc->rec != NULL)
+	    cairo_surface_destroy (cc->rec);
+
+	cc->rec = job->rec;
+	cc->rec_width = job->allocation.width;
+	cc->rec_height = job->allocation.height;
+	cc->rec_gen = job->gen;
+    }
+    else
+    {
+	cairo_surface_destroy (job->rec);
+    }
+
+    /* Either shows the recording or starts another for the latest data or size */
+    gtk_widget_queue_draw (job->widget);
+
+    g_object_unref (job->widget);
+    cairo_font_face_destroy (job->face);
+    free(job);
+
+    return FALSE;
+}
+
+
+/* Draw a chart of the given type (under the chart lock) */
+
+void draw_chart_typ(cairo_t *cr, int typ, MainUi *m_ui, GtkAllocation *allocation)
+{
+    switch (typ)
+    {
+    	case CHART_OVERVIEW:
+	    if (m_ui->pie_chart != NULL && m_ui->bar_chart != NULL)
+		draw_overview(cr, m_ui->pie_chart, m_ui->bar_chart, allocation);
+	    break;
+
+    	case CHART_HISTORY:
+	    if (m_ui->hist_usg_graph != NULL)
+		draw_history(cr, m_ui->hist_usg_graph, allocation);
+	    break;
+
+	default:
+	    break;
+    }
+
+    return;
+}
+
+
+/* Chart objects lock */
+
+void chart_lock()
+{
+    pthread_mutex_lock(&chart_mutex);
+
+    return;
+}
+
+
+void chart_unlock()
+{
+    pthread_mutex_unlock(&chart_mutex);
+
+    return;
+}
@@ -63,6 +63,9 @@ const GdkRGBA BLACK = {0.0, 0.0, 0.0, 1.0};
 const GdkRGBA LIGHT_RED = {0.91, 0.57, 0.57, 1.0};
 const GdkRGBA MID_YELLOW = {0.94, 0.95, 0.61, 1.0};
 const GdkRGBA DARK_MAROON = {0.38, 0.09, 0.09, 1.0};
+const GdkRGBA DARK_GREEN = {0.13, 0.45, 0.13, 1.0};
+const GdkRGBA MID_ORANGE = {0.95, 0.6, 0.2, 1.0};
+const GdkRGBA MID_PURPLE = {0.55, 0.35, 0.7, 1.0};
 #else
 extern const GdkRGBA DARK_BLUE;
 extern const GdkRGBA LIGHT_BLUE;
@@ -71,6 +74,9 @@ extern const GdkRGBA BLACK;
 extern const GdkRGBA LIGHT_RED;
 extern const GdkRGBA MID_YELLOW;
 extern const GdkRGBA DARK_MAROON;
+extern const GdkRGBA DARK_GREEN;
+extern const GdkRGBA MID_ORANGE;
+extern const GdkRGBA MID_PURPLE;
 #endif
 #endif
 
@@ -107,7 +113,15 @@ extern const GdkRGBA DARK_MAROON;
 #define OV_BAR_LBL "ovbarlbl"
 #define OV_VER_LBL "ovverlbl"
 #define REFRESH_TM "refresh"
+#define REFRESH_MODE "refmode"
+#define REFRESH_MIN "refmin"
+#define REFRESH_MAX "refmax"
 #define VER_CHQ "ovverlbl"
+#define LOG_MAX_SZ "logmaxsz"
+#define LOG_MAX_AGE "logage"
+#define LOG_CAP "logcap"
+#define MON_INTVL "monintvl"
+#define MON_HIST "monhist"
 #endif
 
 
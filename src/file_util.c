@@ -0,0 +1,184 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:
+**  File I/O utilities
+**  Whole file reads use a read only mapping where the file size is known.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Defines */
+
+#define READ_CHUNK 4096
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <glib.h>
+#include <file_util.h>
+
+
+/* Prototypes */
+
+int map_file(char *, FileBuf *);
+int read_fd_all(int, FileBuf *);
+void unmap_file(FileBuf *);
+
+extern int check_errno();
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-file_util.c ";
+
+
+
+/* Map an entire file for read. Files that report no size (eg. /proc) are read into a buffer */
+
+int map_file(char *fn, FileBuf *fb)
+{
+    int fd;
+    struct stat fileStat;
+
+    fb->buf = NULL;
+    fb->len = 0;
+    fb->mapped = FALSE;
+
+    if ((fd = open(fn, O_RDONLY | O_CLOEXEC)) < 0)
+    {
+    	check_errno();
+    	return FALSE;
+    }
+
+    if (fstat(fd, &fileStat) < 0)
+    {
+    	check_errno();
+    	close(fd);
+    	return FALSE;
+    }
+
+    /* Pseudo files and empty files */
+    if (! S_ISREG(fileStat.st_mode) || fileStat.st_size == 0)
+    {
+    	if (read_fd_all(fd, fb) == FALSE)
+    	{
+	    close(fd);
+	    return FALSE;
+    	}
+
+	close(fd);
+	return TRUE;
+    }
+
+    fb->len = (size_t) fileStat.st_size;
+    fb->buf = mmap(NULL, fb->len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (fb->buf == MAP_FAILED)
+    {
+    	check_errno();
+	fb->buf = NULL;
+	fb->len = 0;
+	return FALSE;
+    }
+
+    fb->mapped = TRUE;
+
+    return TRUE;
+}
+
+
+/* Read from a descriptor until end of file into a buffer (null terminated, not counted in the length) */
+
+int read_fd_all(int fd, FileBuf *fb)
+{
+    ssize_t n;
+    size_t sz;
+
+    sz = READ_CHUNK;
+    fb->buf = (char *) malloc(sz);
+    fb->len = 0;
+    fb->mapped = FALSE;
+
+    while((n = read(fd, fb->buf + fb->len, sz - fb->len - 1)) != 0)
+    {
+    	if (n < 0)
+    	{
+	    if (errno == EINTR)
+	    	continue;
+
+	    check_errno();
+	    free(fb->buf);
+	    fb->buf = NULL;
+	    fb->len = 0;
+	    return FALSE;
+    	}
+
+	fb->len += (size_t) n;
+
+	if (fb->len + 1 >= sz)
+	{
+	    sz *= 2;
+	    fb->buf = (char *) realloc(fb->buf, sz);
+	}
+    }
+
+    fb->buf[fb->len] = '\0';
+
+    return TRUE;
+}
+
+
+/* Release a file buffer */
+
+void unmap_file(FileBuf *fb)
+{
+    if (fb->buf == NULL)
+    	return;
+
+    if (fb->mapped == TRUE)
+	munmap(fb->buf, fb->len);
+    else
+	free(fb->buf);
+
+    fb->buf = NULL;
+    fb->len = 0;
+    fb->mapped = FALSE;
+
+    return;
+}
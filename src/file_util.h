@@ -0,0 +1,53 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	File I/O utilities include file
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial
+**
+*/
+
+
+/* Defines */
+
+#ifndef FILE_UTIL_HDR
+#define FILE_UTIL_HDR
+#endif
+
+
+/* Includes */
+
+#include <stddef.h>
+
+
+/* Whole file contents - either a read only mapping or (for /proc, /sys etc.) a read buffer */
+
+typedef struct _file_buf
+{
+    char *buf;
+    size_t len;
+    int mapped;
+} FileBuf;
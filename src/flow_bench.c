@@ -0,0 +1,295 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:
+**  Flow table benchmark - replays a capture file (pcap or pcapng) through the flow table
+**  used for the Monitor 'Top talkers' list, as fast as possible. No root or live traffic
+**  is needed. The file is read into memory first (headers only) so the timing is of the
+**  aggregation alone; the file read rate is shown separately.
+**
+**  Usage:  flow_bench [-r repeat] [-l local_address] ... file
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Defines */
+
+#define MAX_LOCAL 32
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <pcap.h>
+#include <net_stats.h>
+
+
+/* Types */
+
+typedef struct _bench_pkt
+{
+    unsigned int caplen;
+    unsigned int len;
+    unsigned char data[CAP_SNAPLEN];
+} BenchPkt;
+
+
+/* Prototypes */
+
+int load_file(char *, BenchPkt **, long *, int *);
+int add_local(char *, FlowKey *);
+double mono_secs();
+void usage();
+
+extern FlowTable * flow_table_new(unsigned int);
+extern void flow_table_free(FlowTable *);
+extern void flow_table_clear(FlowTable *);
+extern void flow_set_local(FlowTable *, FlowKey *, int);
+extern int flow_account(FlowTable *, int, const unsigned char *, unsigned int, unsigned int);
+extern int flow_top(FlowTable *, FlowEntry *, int);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-flow_bench.c ";
+
+
+
+/* Load the file, run the flow table over the packets 'repeat' times and report */
+
+int main(int argc, char *argv[])
+{
+    int c, i, dlt, repeat, local_cnt, top_cnt;
+    long r, n, ip_cnt;
+    double t0, secs, load_secs;
+    unsigned long long wire;
+    char s[INET6_ADDRSTRLEN];
+    BenchPkt *pkts;
+    FlowTable *ft;
+    FlowKey local[MAX_LOCAL];
+    FlowEntry top[TOP_TALKERS];
+
+    repeat = 1;
+    local_cnt = 0;
+
+    while((c = getopt(argc, argv, "r:l:h")) != -1)
+    {
+	switch(c)
+	{
+	    case 'r':
+		if ((repeat = atoi(optarg)) < 1)
+		    repeat = 1;
+		break;
+
+	    case 'l':
+		if (local_cnt < MAX_LOCAL && add_local(optarg, &local[local_cnt]) == 1)
+		    local_cnt++;
+		else
+		    fprintf(stderr, "Invalid local address: %s\n", optarg);
+		break;
+
+	    default:
+		usage();
+		return 1;
+	}
+    }
+
+    if (optind >= argc)
+    {
+	usage();
+	return 1;
+    }
+
+    /* Read the packets */
+    t0 = mono_secs();
+
+    if (load_file(argv[optind], &pkts, &n, &dlt) == 0)
+    	return 1;
+
+    load_secs = mono_secs() - t0;
+
+    for(i = 0, wire = 0; i < n; i++)
+    	wire += pkts[i].len;
+
+    /* Aggregate */
+    if ((ft = flow_table_new(1024)) == NULL)
+    {
+	fprintf(stderr, "Out of memory\n");
+    	return 1;
+    }
+
+    flow_set_local(ft, local, local_cnt);
+    ip_cnt = 0;
+    t0 = mono_secs();
+
+    for(r = 0; r < repeat; r++)
+    {
+	flow_table_clear(ft);
+	ip_cnt = 0;
+
+	for(i = 0; i < n; i++)
+	    ip_cnt += flow_account(ft, dlt, pkts[i].data, pkts[i].caplen, pkts[i].len);
+    }
+
+    secs = mono_secs() - t0;
+
+    /* Report */
+    printf("File:            %s (link type %d)\n", argv[optind], dlt);
+    printf("Packets:         %ld (%ld IP), %llu bytes on the wire\n", n, ip_cnt, wire);
+    printf("File read:       %.3f s, %.0f packets/s\n", load_secs, (load_secs > 0.0) ? (double) n / load_secs : 0.0);
+    printf("Aggregation:     %d pass(es) in %.3f s\n", repeat, secs);
+
+    if (secs > 0.0)
+    {
+	printf("                 %.0f packets/s, %.1f MB/s (wire bytes)\n",
+	       (double) n * repeat / secs, (double) wire * repeat / secs / (1024.0 * 1024.0));
+	printf("                 %.1f ns/packet\n", secs * 1.0e9 / ((double) n * repeat));
+    }
+
+    printf("Flow table:      %u flows in %u slots (%.1f%% occupied), %llu packets to 'other'\n",
+    	   ft->cnt, ft->sz, 100.0 * ft->cnt / ft->sz, ft->other.pkts);
+
+    top_cnt = flow_top(ft, top, TOP_TALKERS);
+
+    for(i = 0; i < top_cnt; i++)
+    {
+	inet_ntop((top[i].key.family == 4) ? AF_INET : AF_INET6, top[i].key.addr, s, sizeof(s));
+	printf("    %-40s %5u/%-3u rx %12llu  tx %12llu\n", s, top[i].key.port, top[i].key.proto,
+	       top[i].rx_bytes, top[i].tx_bytes);
+    }
+
+    flow_table_free(ft);
+    free(pkts);
+
+    return 0;
+}
+
+
+/* Read all the packets (up to the capture snapshot length) into memory */
+
+int load_file(char *fn, BenchPkt **pkts, long *n, int *dlt)
+{
+    int r;
+    long max;
+    char errbuf[PCAP_ERRBUF_SIZE];
+    pcap_t *p;
+    struct pcap_pkthdr *hdr;
+    const u_char *data;
+    BenchPkt *bp;
+
+    if ((p = pcap_open_offline(fn, errbuf)) == NULL)
+    {
+	fprintf(stderr, "%s\n", errbuf);
+	return 0;
+    }
+
+    *dlt = pcap_datalink(p);
+    *n = 0;
+    max = 65536;
+    *pkts = (BenchPkt *) malloc(max * sizeof(BenchPkt));
+
+    while((r = pcap_next_ex(p, &hdr, &data)) == 1)
+    {
+	if (*n >= max)
+	{
+	    max *= 2;
+
+	    if ((bp = (BenchPkt *) realloc(*pkts, max * sizeof(BenchPkt))) == NULL)
+	    {
+		fprintf(stderr, "Out of memory\n");
+		pcap_close(p);
+		return 0;
+	    }
+
+	    *pkts = bp;
+	}
+
+	bp = &((*pkts)[(*n)++]);
+	bp->caplen = (hdr->caplen < CAP_SNAPLEN) ? hdr->caplen : CAP_SNAPLEN;
+	bp->len = hdr->len;
+	memcpy(bp->data, data, bp->caplen);
+    }
+
+    if (r == -1)
+	fprintf(stderr, "%s (continuing with %ld packets)\n", pcap_geterr(p), *n);
+
+    pcap_close(p);
+
+    return 1;
+}
+
+
+/* Parse a local address */
+
+int add_local(char *s, FlowKey *key)
+{
+    memset(key, 0, sizeof(FlowKey));
+
+    if (inet_pton(AF_INET, s, key->addr) == 1)
+    {
+	key->family = 4;
+	return 1;
+    }
+
+    if (inet_pton(AF_INET6, s, key->addr) == 1)
+    {
+	key->family = 6;
+	return 1;
+    }
+
+    return 0;
+}
+
+
+/* Monotonic clock time in seconds */
+
+double mono_secs()
+{
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+
+    return (double) tp.tv_sec + (double) tp.tv_nsec / 1000000000.0;
+}
+
+
+/* Usage */
+
+void usage()
+{
+    fprintf(stderr, "Usage: flow_bench [-r repeat] [-l local_address] ... file\n");
+    fprintf(stderr, "  Replays a pcap or pcapng file through the flow table and reports the rate.\n");
+    fprintf(stderr, "  Local addresses decide whether traffic is sent or received.\n");
+
+    return;
+}
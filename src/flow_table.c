@@ -0,0 +1,425 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:
+**  Flow table for captured packets - bytes to and from each remote host and port.
+**  Open addressing with linear probing in a power of 2 array that doubles at 3/4 full
+**  up to FLOW_MAX entries. Only packet headers are looked at (no GTK, so the offline
+**  benchmark can use it as well).
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Includes */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pcap.h>
+#include <net_stats.h>
+
+
+/* Defines */
+
+#define TRUE 1
+#define FALSE 0
+
+
+/* Prototypes */
+
+FlowTable * flow_table_new(unsigned int);
+void flow_table_free(FlowTable *);
+void flow_table_clear(FlowTable *);
+void flow_set_local(FlowTable *, FlowKey *, int);
+int flow_account(FlowTable *, int, const unsigned char *, unsigned int, unsigned int);
+FlowEntry * flow_lookup(FlowTable *, FlowKey *);
+int flow_grow(FlowTable *);
+int flow_top(FlowTable *, FlowEntry *, int);
+unsigned int flow_hash(FlowKey *);
+int is_local(FlowTable *, const unsigned char *, int);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-flow_table.c ";
+
+
+
+/* New table with an initial size (rounded up to a power of 2) */
+
+FlowTable * flow_table_new(unsigned int n)
+{
+    FlowTable *ft;
+
+    if ((ft = (FlowTable *) calloc(1, sizeof(FlowTable))) == NULL)
+    	return NULL;
+
+    ft->sz = 16;
+
+    while(ft->sz < n && ft->sz < FLOW_MAX)
+    	ft->sz <<= 1;
+
+    if ((ft->ent = (FlowEntry *) calloc(ft->sz, sizeof(FlowEntry))) == NULL)
+    {
+	free(ft);
+    	return NULL;
+    }
+
+    return ft;
+}
+
+
+/* Free a table */
+
+void flow_table_free(FlowTable *ft)
+{
+    if (ft == NULL)
+    	return;
+
+    free(ft->ent);
+    free(ft->local);
+    free(ft);
+
+    return;
+}
+
+
+/* Empty a table (keeps its size) */
+
+void flow_table_clear(FlowTable *ft)
+{
+    memset(ft->ent, 0, ft->sz * sizeof(FlowEntry));
+    memset(&(ft->other), 0, sizeof(FlowEntry));
+    ft->cnt = 0;
+    ft->pkts = 0;
+    ft->bytes = 0;
+
+    return;
+}
+
+
+/* Set the local addresses (a copy is kept) */
+
+void flow_set_local(FlowTable *ft, FlowKey *addr, int n)
+{
+    free(ft->local);
+    ft->local = NULL;
+    ft->local_cnt = 0;
+
+    if (n <= 0)
+    	return;
+
+    ft->local = (FlowKey *) malloc(n * sizeof(FlowKey));
+    memcpy(ft->local, addr, n * sizeof(FlowKey));
+    ft->local_cnt = n;
+
+    return;
+}
+
+
+/*
+** Account for a packet given its link type (DLT_*), captured bytes and length on the wire.
+** The remote end is whichever address is not local (the source if neither is).
+** Returns FALSE if the packet is not IP or is too short.
+*/
+
+int flow_account(FlowTable *ft, int dlt, const unsigned char *pkt, unsigned int caplen, unsigned int wirelen)
+{
+    unsigned int off, l3, ihl, ethtype;
+    unsigned char proto;
+    const unsigned char *src, *dst, *rem;
+    int alen, tx, rem_is_src;
+    FlowKey key;
+    FlowEntry *fe;
+
+    /* Link layer */
+    switch(dlt)
+    {
+	case DLT_EN10MB:
+	    if (caplen < 14)
+	    	return FALSE;
+
+	    off = 14;
+	    ethtype = (pkt[12] << 8) | pkt[13];
+
+	    if ((ethtype == 0x8100 || ethtype == 0x88a8) && caplen >= 18)
+	    {
+		ethtype = (pkt[16] << 8) | pkt[17];
+		off = 18;
+	    }
+	    break;
+
+	case DLT_LINUX_SLL:
+	    if (caplen < 16)
+	    	return FALSE;
+
+	    off = 16;
+	    ethtype = (pkt[14] << 8) | pkt[15];
+	    break;
+
+#ifdef DLT_LINUX_SLL2
+	case DLT_LINUX_SLL2:
+	    if (caplen < 20)
+	    	return FALSE;
+
+	    off = 20;
+	    ethtype = (pkt[0] << 8) | pkt[1];
+	    break;
+#endif
+
+	case DLT_RAW:
+	    if (caplen < 1)
+	    	return FALSE;
+
+	    off = 0;
+	    ethtype = ((pkt[0] >> 4) == 6) ? 0x86dd : 0x0800;
+	    break;
+
+	default:
+	    return FALSE;
+    }
+
+    /* Network layer */
+    if (ethtype == 0x0800)
+    {
+	if (caplen < off + 20)
+	    return FALSE;
+
+	ihl = (pkt[off] & 0x0f) * 4;
+	proto = pkt[off + 9];
+	src = pkt + off + 12;
+	dst = pkt + off + 16;
+	alen = 4;
+
+	/* Only the first fragment has the ports */
+	l3 = ((((pkt[off + 6] & 0x1f) << 8) | pkt[off + 7]) == 0) ? off + ihl : 0;
+    }
+    else if (ethtype == 0x86dd)
+    {
+	if (caplen < off + 40)
+	    return FALSE;
+
+	proto = pkt[off + 6];
+	src = pkt + off + 8;
+	dst = pkt + off + 24;
+	alen = 16;
+	l3 = off + 40;
+    }
+    else
+    {
+	return FALSE;
+    }
+
+    /* Direction */
+    if (is_local(ft, src, alen) == TRUE)
+    {
+	rem = dst;
+	rem_is_src = FALSE;
+	tx = TRUE;
+    }
+    else
+    {
+	rem = src;
+	rem_is_src = TRUE;
+	tx = FALSE;
+    }
+
+    /* Key - remote address, remote port (TCP and UDP) and protocol */
+    memset(&key, 0, sizeof(key));
+    memcpy(key.addr, rem, alen);
+    key.family = (alen == 4) ? 4 : 6;
+    key.proto = proto;
+
+    if ((proto == 6 || proto == 17) && l3 != 0 && caplen >= l3 + 4)
+	key.port = (rem_is_src == TRUE) ? (pkt[l3] << 8) | pkt[l3 + 1] : (pkt[l3 + 2] << 8) | pkt[l3 + 3];
+
+    fe = flow_lookup(ft, &key);
+
+    if (tx == TRUE)
+    	fe->tx_bytes += wirelen;
+    else
+    	fe->rx_bytes += wirelen;
+
+    fe->pkts++;
+    ft->pkts++;
+    ft->bytes += wirelen;
+
+    return TRUE;
+}
+
+
+/*
+** Find or add the entry for a key. The table is full when it is 3/4 used and cannot grow,
+** which keeps probes short. Flows already in it are still found and only new ones go to
+** the 'other' entry.
+*/
+
+FlowEntry * flow_lookup(FlowTable *ft, FlowKey *key)
+{
+    int full;
+    unsigned int i, m;
+    FlowEntry *fe;
+
+    full = FALSE;
+
+    if (ft->cnt >= ft->sz - (ft->sz >> 2))
+    {
+	if (flow_grow(ft) == FALSE)
+	    full = TRUE;
+    }
+
+    m = ft->sz - 1;
+
+    for(i = flow_hash(key) & m; ; i = (i + 1) & m)
+    {
+	fe = &(ft->ent[i]);
+
+	if (fe->used == FALSE)
+	{
+	    if (full == TRUE)
+	    	return &(ft->other);
+
+	    fe->key = *key;
+	    fe->used = TRUE;
+	    ft->cnt++;
+	    return fe;
+	}
+
+	if (memcmp(&(fe->key), key, sizeof(FlowKey)) == 0)
+	    return fe;
+    }
+}
+
+
+/* Double the table size (not past FLOW_MAX) */
+
+int flow_grow(FlowTable *ft)
+{
+    unsigned int i, j, m, sz;
+    FlowEntry *ent;
+
+    if (ft->sz >= FLOW_MAX)
+    	return FALSE;
+
+    sz = ft->sz << 1;
+
+    if ((ent = (FlowEntry *) calloc(sz, sizeof(FlowEntry))) == NULL)
+    	return FALSE;
+
+    m = sz - 1;
+
+    for(i = 0; i < ft->sz; i++)
+    {
+	if (ft->ent[i].used == FALSE)
+	    continue;
+
+	for(j = flow_hash(&(ft->ent[i].key)) & m; ent[j].used == TRUE; j = (j + 1) & m);
+
+	ent[j] = ft->ent[i];
+    }
+
+    free(ft->ent);
+    ft->ent = ent;
+    ft->sz = sz;
+
+    return TRUE;
+}
+
+
+/* The 'n' flows with the most bytes (in and out), largest first. Returns the number found */
+
+int flow_top(FlowTable *ft, FlowEntry *top, int n)
+{
+    unsigned int i;
+    int j, k, cnt;
+    unsigned long long tot;
+    FlowEntry *fe;
+
+    cnt = 0;
+
+    for(i = 0; i < ft->sz; i++)
+    {
+	fe = &(ft->ent[i]);
+
+	if (fe->used == FALSE)
+	    continue;
+
+	tot = fe->rx_bytes + fe->tx_bytes;
+
+	/* Insertion into the (short) sorted list */
+	for(j = cnt; j > 0 && top[j - 1].rx_bytes + top[j - 1].tx_bytes < tot; j--);
+
+	if (j >= n)
+	    continue;
+
+	for(k = (cnt < n) ? cnt : n - 1; k > j; k--)
+	    top[k] = top[k - 1];
+
+	top[j] = *fe;
+
+	if (cnt < n)
+	    cnt++;
+    }
+
+    return cnt;
+}
+
+
+/* FNV-1a hash of a key */
+
+unsigned int flow_hash(FlowKey *key)
+{
+    unsigned int i, h;
+    const unsigned char *p;
+
+    h = 2166136261U;
+    p = (const unsigned char *) key;
+
+    for(i = 0; i < sizeof(FlowKey); i++)
+    {
+	h ^= p[i];
+	h *= 16777619U;
+    }
+
+    return h;
+}
+
+
+/* Check for a local address (only the family and address of the local list are used) */
+
+int is_local(FlowTable *ft, const unsigned char *addr, int alen)
+{
+    int i;
+
+    for(i = 0; i < ft->local_cnt; i++)
+    {
+	if (ft->local[i].family == ((alen == 4) ? 4 : 6) && memcmp(ft->local[i].addr, addr, alen) == 0)
+	    return TRUE;
+    }
+
+    return FALSE;
+}
@@ -26,6 +26,8 @@
 **
 ** History
 **	11-Dec-2017	Initial code
+**	19-Oct-2026	All usage categories as graph series (toggled, not re-queried)
+**	19-Oct-2026	Panel built on first view
 **
 */
 
@@ -60,13 +62,14 @@ void create_hist_graph(ServUsage *, MainUi *);
 void reset_history(MainUi *);
 void set_x_step(int, double *);
 void set_y_step(int, long long, double *);
+void hist_series_vis(MainUi *);
 
 extern void OnHistFind(GtkWidget *, gpointer); 
 extern void OnCalendar(GtkWidget *, gpointer); 
+extern void OnHistSeries(GtkToggleButton *, gpointer); 
 extern gboolean OnHistExpose (GtkWidget*, cairo_t *, gpointer);
 extern void create_label(GtkWidget **, char *, char *, GtkWidget *, int, int, int, int);
 extern void create_entry(GtkWidget **, char *, GtkWidget *, int, int);
-extern void create_cbox(GtkWidget **, char *, const char *[], int, int, GtkWidget *, int, int);
 extern ServUsage * get_service_usage();
 extern int get_hist_service_usage(IspData *, MainUi *);
 extern char * format_usg(char *, char *);
@@ -75,10 +78,14 @@ extern LineGraph * line_graph_create(char *, const GdkRGBA *, int,
 				     char *, double, double,
 				     const GdkRGBA *, int, const GdkRGBA *, int,
 				     char *, double, double,
-				     const GdkRGBA *, int, const GdkRGBA *, int,
-				     const GdkRGBA *);
-extern void line_graph_add_point(LineGraph *, double, double);
+				     const GdkRGBA *, int, const GdkRGBA *, int);
+extern LineSeries * line_graph_add_series(LineGraph *, char *, const GdkRGBA *);
+extern void line_graph_add_point(LineGraph *, LineSeries *, double, double);
+extern void line_graph_series_visible(LineGraph *, int, int);
 extern void free_line_graph(LineGraph *);
+extern void chart_cache_inval(ChartCache *);
+extern void chart_lock();
+extern void chart_unlock();
 extern void set_line_graph_bounds(LineGraph *);
 extern int long_chars(long);
 
@@ -86,6 +93,8 @@ extern int long_chars(long);
 /* Globals */
 
 static const char *debug_hdr = "DEBUG-history.c ";
+static const char *usg_cats[] = { "Total", "Metered up", "Metered down", "Unmetered up", "Unmetered down" };
+static const GdkRGBA *usg_cat_colours[] = { &LIGHT_RED, &DARK_BLUE, &DARK_GREEN, &MID_ORANGE, &MID_PURPLE };
 
 
 
@@ -93,11 +102,11 @@ static const char *debug_hdr = "DEBUG-history.c ";
 
 void history_panel(MainUi *m_ui)
 {  
+    int i;
     GtkWidget *sum_grid;
     GtkWidget *lbl;
     GtkWidget *frame;
-    const char *usg_cats[] = { "Total", "Metered up", "Metered down", "Unmetered up", "Unmetered down" };
-    const int usg_cat_max = 5;
+    GtkWidget *series_box;
 
     /* Create main container grid */
     m_ui->hist_cntr = gtk_grid_new();
@@ -119,8 +128,23 @@ void history_panel(MainUi *m_ui)
 
     g_signal_connect (m_ui->hist_graph_area, "draw", G_CALLBACK (OnHistExpose), m_ui);
 
+    /* Usage categories shown on the graph (only total initially) */
+    series_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    gtk_widget_set_halign (series_box, GTK_ALIGN_CENTER);
+
+    for(i = 0; i < HIST_CATS; i++)
+    {
+	m_ui->hist_series_chk[i] = gtk_check_button_new_with_label(usg_cats[i]);
+	gtk_widget_set_name (m_ui->hist_series_chk[i], "hist_chk");
+	gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (m_ui->hist_series_chk[i]), (i == 0));
+	gtk_box_pack_start (GTK_BOX (series_box), m_ui->hist_series_chk[i], FALSE, FALSE, 0);
+	g_signal_connect (m_ui->hist_series_chk[i], "toggled", G_CALLBACK (OnHistSeries), m_ui);
+    }
+
+    gtk_grid_attach(GTK_GRID (m_ui->hist_cntr), series_box, 0, 1, 1, 1);
+
     /* Summary total data */
-    create_label(&(m_ui->hist_total), "data_2", "Total Usage: ", m_ui->hist_cntr, 0, 1, 1, 1);
+    create_label(&(m_ui->hist_total), "data_2", "Total Usage: ", m_ui->hist_cntr, 0, 2, 1, 1);
     gtk_widget_set_margin_bottom (m_ui->hist_total, 10);
     gtk_widget_set_halign(GTK_WIDGET (m_ui->hist_total), GTK_ALIGN_START);
 
@@ -156,12 +180,9 @@ void history_panel(MainUi *m_ui)
     gtk_grid_attach(GTK_GRID (m_ui->hist_search_cntr), m_ui->to_btn, 2, 1, 1, 1);
     g_signal_connect (m_ui->to_btn, "clicked", G_CALLBACK (OnCalendar), m_ui);
 
-    create_label(&(m_ui->cat_lbl), "cat_lbl", "Category", m_ui->hist_search_cntr, 0, 2, 1, 1);
-    create_cbox(&(m_ui->usgcat_cbox), "usg_cat", usg_cats, usg_cat_max, 0, m_ui->hist_search_cntr, 1, 2);
-
     m_ui->hist_search_btn = gtk_button_new_with_label("Find");
     gtk_widget_set_name ( m_ui->hist_search_btn, "button_1");
-    gtk_grid_attach(GTK_GRID (m_ui->hist_search_cntr), m_ui->hist_search_btn, 1, 3, 1, 1);
+    gtk_grid_attach(GTK_GRID (m_ui->hist_search_cntr), m_ui->hist_search_btn, 1, 2, 1, 1);
     gtk_widget_set_margin_top (m_ui->hist_search_btn, 2);
     g_signal_connect (m_ui->hist_search_btn, "clicked", G_CALLBACK (OnHistFind), m_ui);
 
@@ -169,7 +190,7 @@ void history_panel(MainUi *m_ui)
     gtk_container_add(GTK_CONTAINER (frame), m_ui->hist_search_cntr);
 
     /* Add summary to history container */
-    gtk_grid_attach(GTK_GRID (m_ui->hist_cntr), frame, 0, 2, 1, 1);
+    gtk_grid_attach(GTK_GRID (m_ui->hist_cntr), frame, 0, 3, 1, 1);
 
     /* Add to the panel stack */
     gtk_stack_add_named (GTK_STACK (m_ui->panel_stk), m_ui->hist_cntr, "hist_panel");
@@ -185,6 +206,10 @@ void init_history(MainUi *m_ui)
     const gchar *nm;
     IspData *isp_data;
 
+    /* Panel not shown yet */
+    if (m_ui->hist_cntr == NULL)
+    	return;
+
     gtk_entry_set_text (GTK_ENTRY(m_ui->hist_from_dt), "");
     gtk_entry_set_text (GTK_ENTRY(m_ui->hist_to_dt), "");
 
@@ -219,7 +244,6 @@ void load_history(IspData *isp_data, MainUi *m_ui)
     /* Show current search values */
     gtk_entry_set_text (GTK_ENTRY(m_ui->hist_from_dt), srv_usg->hist_from_dt);
     gtk_entry_set_text (GTK_ENTRY(m_ui->hist_to_dt), srv_usg->hist_to_dt);
-    gtk_combo_box_set_active (GTK_COMBO_BOX(m_ui->usgcat_cbox), srv_usg->last_cat_idx);
 
     /* Set total bytes */
     chart_total(srv_usg, m_ui);
@@ -238,7 +262,6 @@ void load_history(IspData *isp_data, MainUi *m_ui)
 
 void reset_history(MainUi *m_ui)
 {  
-    int cat_idx;
     const gchar *dt_fr, *dt_to;
     IspData *isp_data;
     ServUsage *srv_usg;
@@ -250,7 +273,6 @@ void reset_history(MainUi *m_ui)
     /* Date changes force a new Isp query */
     dt_fr = gtk_entry_get_text (GTK_ENTRY(m_ui->hist_from_dt));
     dt_to = gtk_entry_get_text (GTK_ENTRY(m_ui->hist_to_dt));
-    cat_idx = gtk_combo_box_get_active (GTK_COMBO_BOX(m_ui->usgcat_cbox));
 
     if ((strcmp(dt_fr, srv_usg->hist_from_dt) != 0) || (strcmp(dt_to, srv_usg->hist_to_dt) != 0))
     {
@@ -258,10 +280,6 @@ void reset_history(MainUi *m_ui)
 	strcpy(srv_usg->hist_to_dt, dt_to);
     	get_hist_service_usage(isp_data, m_ui);
     }
-    else if (srv_usg->last_cat_idx != cat_idx)
-    {
-    	srv_usg->last_cat_idx = cat_idx;
-    }
     else
     {
     	return;
@@ -273,9 +291,8 @@ void reset_history(MainUi *m_ui)
     /* Set up usage graphs */
     create_hist_graph(srv_usg, m_ui);
 
-    /* Hide and show should force an expose event */
-    gtk_widget_hide(m_ui->hist_graph_area);
-    gtk_widget_show(m_ui->hist_graph_area);
+    /* Force an expose event (the cached image is stale) */
+    gtk_widget_queue_draw(m_ui->hist_graph_area);
 
     return;
 }
@@ -289,7 +306,7 @@ void chart_total(ServUsage *srv_usg, MainUi *m_ui)
     int i;
     char *s, *s2, *amt;
 
-    ll = srv_usg->hist_tot_arr[srv_usg->last_cat_idx];
+    ll = srv_usg->hist_tot_arr[0];
     i = llong_chars(ll);
     amt = (char *) malloc(i + 1);
     sprintf(amt, "%lld", ll);
@@ -311,24 +328,30 @@ void chart_total(ServUsage *srv_usg, MainUi *m_ui)
 
 void create_hist_graph(ServUsage *srv_usg, MainUi *m_ui)
 {  
-    int i, zdays;
+    int i, j, zdays;
     double x_step, y_step;
+    LineSeries *ls[HIST_CATS];
+
+    /* Reset any existing graph (not while a chart worker is using it) */
+    chart_lock();
 
-    /* Reset any existing graph */
     if (m_ui->hist_usg_graph != NULL)
     	free_line_graph(m_ui->hist_usg_graph);
 
+    chart_cache_inval(&(m_ui->hist_cache));
+
     /* Determine axis step marks interval (subtract 1 for day 0) */
     zdays = 0;
 
     for(i = 1; i < srv_usg->hist_days; i++)		// ***** NB should this be days + 1?
     {
-    	if (srv_usg->hist_usg_arr[i][srv_usg->last_cat_idx] == 0)
+    	if (srv_usg->hist_usg_arr[i][0] == 0)
 	    zdays++;
     }
 
+    /* The axes are shared, the total is the largest category */
     set_x_step(srv_usg->hist_days - 1, &x_step);
-    set_y_step(srv_usg->hist_days - zdays - 1, srv_usg->hist_tot_arr[srv_usg->last_cat_idx], &y_step);
+    set_y_step(srv_usg->hist_days - zdays - 1, srv_usg->hist_tot_arr[0], &y_step);
 
 /* Debug
 printf("%s create_hist_graph 3 days %d xstep %0.0f ystep %0.2f zdays %d hist_days %d\n", 
@@ -342,19 +365,54 @@ fflush(stdout);
 		"Days", x_step, 0,
 		&DARK_MAROON, 10, &DARK_BLUE, 8,
 		"MB", y_step, 0,
-		&DARK_MAROON, 10, &DARK_BLUE, 8,
-		&LIGHT_RED);
+		&DARK_MAROON, 10, &DARK_BLUE, 8);
 
-    /* Build the list of graph points - use actual values: they are adjusted on drawing */
+    /* A series for each usage category */
+    for(j = 0; j < HIST_CATS; j++)
+    	ls[j] = line_graph_add_series(m_ui->hist_usg_graph, (char *) usg_cats[j], usg_cat_colours[j]);
+
+    /* Build the graph points (all categories in one pass) - use actual values: they are adjusted on drawing */
     /* Day forms the X axis and data usage forms the Y axis */
     for(i = 0; i < srv_usg->hist_days; i++)		// ***** NB should this be days + 1?
-    	line_graph_add_point(m_ui->hist_usg_graph, 
-			     (double) i, 
-			     (double) srv_usg->hist_usg_arr[i][srv_usg->last_cat_idx] / 1000000.0);
+    {
+	for(j = 0; j < HIST_CATS; j++)
+	    line_graph_add_point(m_ui->hist_usg_graph, ls[j],
+				 (double) i, 
+				 (double) srv_usg->hist_usg_arr[i][j] / 1000000.0);
+    }
 
     /* Set the high and low graph bounds */
     set_line_graph_bounds(m_ui->hist_usg_graph);
 
+    chart_unlock();
+
+    /* Current selections */
+    hist_series_vis(m_ui);
+
+    return;
+}
+
+
+/* Show or hide the graph series as selected, only a redraw is required */
+
+void hist_series_vis(MainUi *m_ui)
+{  
+    int i;
+
+    if (m_ui->hist_usg_graph == NULL)
+    	return;
+
+    chart_lock();
+
+    for(i = 0; i < HIST_CATS; i++)
+	line_graph_series_visible(m_ui->hist_usg_graph, i, 
+				  gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON (m_ui->hist_series_chk[i])));
+
+    chart_unlock();
+
+    chart_cache_inval(&(m_ui->hist_cache));
+    gtk_widget_queue_draw(m_ui->hist_graph_area);
+
     return;
 }
 
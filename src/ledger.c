@@ -0,0 +1,542 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:
+**  Traffic ledger - per device byte totals kept on disk by the hour.
+**  Counters are sampled on the main loop and the differences accumulated in memory, then
+**  appended as fixed size records (LedgerRec) to ~/.Inodeum/traffic.ldg every so often and
+**  when the hour changes. Several records for the same device and hour simply add up.
+**  Counter resets (reboot, interface re-created) and 32 bit wrap are allowed for. The last
+**  counters and boot id are saved so traffic while the application is closed is not lost.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Defines */
+
+#define LEDGER_FILE "traffic.ldg"
+#define LEDGER_STATE "traffic.st"
+#define BOOT_ID "/proc/sys/kernel/random/boot_id"
+#define LDG_INTVL 60			// Seconds between samples
+#define LDG_FLUSH 900			// Seconds between writes (at most)
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <gtk/gtk.h>
+#include <net_stats.h>
+#include <file_util.h>
+#include <defs.h>
+
+
+/* Prototypes */
+
+int ledger_init();
+void ledger_close();
+gboolean ledger_tick(gpointer);
+void ledger_sample();
+int ledger_flush();
+int ledger_today(char *, unsigned long long, unsigned long long, unsigned long long *, unsigned long long *);
+LedgerDev * ledger_dev(char *);
+unsigned long long counter_delta(unsigned long long, unsigned long long, int);
+int local_day(time_t);
+void load_today();
+int load_state();
+void save_state();
+void read_boot_id(char *, int);
+
+extern int link_stats(LinkStats **, int *);
+extern char * app_dir_path();
+extern void log_msg(char*, char*, char*, GtkWidget*);
+extern int map_file(char *, FileBuf *);
+extern void unmap_file(FileBuf *);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-ledger.c ";
+static char *ldg_fn = NULL;
+static char *st_fn = NULL;
+static char boot_id[40];
+static LedgerDev *ldg_devs = NULL;
+static int ldg_cnt = 0;
+static int ldg_max = 0;
+static unsigned int ldg_hour = 0;
+static int ldg_day = -1;
+static time_t last_flush = 0;
+static guint ldg_tmr = 0;
+static LinkStats *ls = NULL;
+static int ls_max = 0;
+
+
+
+/* Load today's totals and the saved counters, take a first sample and start the timer */
+
+int ledger_init()
+{
+    char *dir;
+
+    dir = app_dir_path();
+    ldg_fn = (char *) malloc(strlen(dir) + strlen(LEDGER_FILE) + 2);
+    sprintf(ldg_fn, "%s/%s", dir, LEDGER_FILE);
+    st_fn = (char *) malloc(strlen(dir) + strlen(LEDGER_STATE) + 2);
+    sprintf(st_fn, "%s/%s", dir, LEDGER_STATE);
+
+    read_boot_id(boot_id, sizeof(boot_id));
+
+    ldg_day = local_day(time(NULL));
+    load_today();
+    load_state();
+
+    last_flush = time(NULL);
+    ledger_sample();
+
+    ldg_tmr = g_timeout_add_seconds(LDG_INTVL, ledger_tick, NULL);
+
+    return TRUE;
+}
+
+
+/* Write anything outstanding and free */
+
+void ledger_close()
+{
+    if (ldg_fn == NULL)
+    	return;
+
+    if (ldg_tmr != 0)
+    {
+	g_source_remove(ldg_tmr);
+	ldg_tmr = 0;
+    }
+
+    ledger_sample();
+    ledger_flush();
+
+    free(ldg_devs);
+    free(ls);
+    free(ldg_fn);
+    free(st_fn);
+    ldg_devs = NULL;
+    ldg_cnt = 0;
+    ldg_max = 0;
+    ls = NULL;
+    ls_max = 0;
+    ldg_fn = NULL;
+    st_fn = NULL;
+
+    return;
+}
+
+
+/* Timer callback */
+
+gboolean ledger_tick(gpointer user_data)
+{
+    ledger_sample();
+
+    return TRUE;
+}
+
+
+/* Sample all devices and accumulate the bytes since the last sample */
+
+void ledger_sample()
+{
+    int i, n, day;
+    time_t now;
+    unsigned int hour;
+    LedgerDev *ld;
+
+    /* Hour or day has changed, write out the previous hour first */
+    now = time(NULL);
+    hour = (unsigned int) (now / 3600);
+
+    if (ldg_hour != 0 && hour != ldg_hour)
+	ledger_flush();
+
+    ldg_hour = hour;
+
+    if ((day = local_day(now)) != ldg_day)
+    {
+	for(i = 0; i < ldg_cnt; i++)
+	{
+	    ldg_devs[i].rx_day = 0;
+	    ldg_devs[i].tx_day = 0;
+	}
+
+	ldg_day = day;
+    }
+
+    /* Counters */
+    if ((n = link_stats(&ls, &ls_max)) < 0)
+    	return;
+
+    for(i = 0; i < n; i++)
+    {
+	if (strcmp(ls[i].name, "lo") == 0)
+	    continue;
+
+	ld = ledger_dev(ls[i].name);
+
+	if (ld->seen == TRUE)
+	{
+	    /* A different interface index means the device has been re-created */
+	    if (ld->ifindex > 0 && ls[i].ifindex > 0 && ld->ifindex != ls[i].ifindex)
+	    {
+		ld->rx_last = 0;
+		ld->tx_last = 0;
+	    }
+
+	    ld->rx_pend += counter_delta(ld->rx_last, ls[i].rx_bytes, ls[i].wrap32);
+	    ld->tx_pend += counter_delta(ld->tx_last, ls[i].tx_bytes, ls[i].wrap32);
+	    ld->rx_day += counter_delta(ld->rx_last, ls[i].rx_bytes, ls[i].wrap32);
+	    ld->tx_day += counter_delta(ld->tx_last, ls[i].tx_bytes, ls[i].wrap32);
+	}
+
+	ld->ifindex = ls[i].ifindex;
+	ld->wrap32 = ls[i].wrap32;
+	ld->rx_last = ls[i].rx_bytes;
+	ld->tx_last = ls[i].tx_bytes;
+	ld->seen = TRUE;
+    }
+
+    if (now - last_flush >= LDG_FLUSH)
+	ledger_flush();
+
+    return;
+}
+
+
+/* Append the outstanding bytes for the current hour (one write for all devices) */
+
+int ledger_flush()
+{
+    int i, n, fd;
+    ssize_t len;
+    LedgerRec *recs;
+
+    last_flush = time(NULL);
+    recs = (LedgerRec *) calloc(ldg_cnt + 1, sizeof(LedgerRec));
+
+    for(i = 0, n = 0; i < ldg_cnt; i++)
+    {
+	if (ldg_devs[i].rx_pend == 0 && ldg_devs[i].tx_pend == 0)
+	    continue;
+
+	recs[n].magic = LDG_MAGIC;
+	recs[n].hour = ldg_hour;
+	memcpy(recs[n].name, ldg_devs[i].name, LINK_NAME_SZ);
+	recs[n].rx_bytes = ldg_devs[i].rx_pend;
+	recs[n].tx_bytes = ldg_devs[i].tx_pend;
+	n++;
+    }
+
+    if (n > 0)
+    {
+	if ((fd = open(ldg_fn, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600)) < 0)
+	{
+	    sprintf(app_msg_extra, "%s", strerror(errno));
+	    log_msg("ERR0054", ldg_fn, "ERR0054", NULL);
+	    free(recs);
+	    return FALSE;
+	}
+
+	len = write(fd, recs, n * sizeof(LedgerRec));
+
+	if (len != (ssize_t) (n * sizeof(LedgerRec)))
+	{
+	    sprintf(app_msg_extra, "%s", (len < 0) ? strerror(errno) : "short write");
+	    log_msg("ERR0054", ldg_fn, "ERR0054", NULL);
+	    close(fd);
+	    free(recs);
+	    return FALSE;
+	}
+
+	close(fd);
+
+	for(i = 0; i < ldg_cnt; i++)
+	{
+	    ldg_devs[i].rx_pend = 0;
+	    ldg_devs[i].tx_pend = 0;
+	}
+    }
+
+    free(recs);
+    save_state();
+
+    return TRUE;
+}
+
+
+/* Today's bytes for a device including any since the last sample (current counters given) */
+
+int ledger_today(char *nm, unsigned long long rx, unsigned long long tx,
+		 unsigned long long *rx_day, unsigned long long *tx_day)
+{
+    int i;
+    LedgerDev *ld;
+
+    for(i = 0; i < ldg_cnt; i++)
+    {
+	ld = &(ldg_devs[i]);
+
+	if (strcmp(ld->name, nm) != 0)
+	    continue;
+
+	*rx_day = ld->rx_day;
+	*tx_day = ld->tx_day;
+
+	if (ld->seen == TRUE)
+	{
+	    *rx_day += counter_delta(ld->rx_last, rx, ld->wrap32);
+	    *tx_day += counter_delta(ld->tx_last, tx, ld->wrap32);
+	}
+
+	return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+/* Find or add a device */
+
+LedgerDev * ledger_dev(char *nm)
+{
+    int i;
+    LedgerDev *ld;
+
+    for(i = 0; i < ldg_cnt; i++)
+    {
+	if (strcmp(ldg_devs[i].name, nm) == 0)
+	    return &(ldg_devs[i]);
+    }
+
+    if (ldg_cnt >= ldg_max)
+    {
+	ldg_max = (ldg_max == 0) ? 8 : ldg_max * 2;
+	ldg_devs = (LedgerDev *) realloc(ldg_devs, ldg_max * sizeof(LedgerDev));
+    }
+
+    ld = &(ldg_devs[ldg_cnt++]);
+    memset(ld, 0, sizeof(LedgerDev));
+    snprintf(ld->name, sizeof(ld->name), "%s", nm);
+
+    return ld;
+}
+
+
+/*
+** Bytes between two counter readings. A lower reading is a reset to 0, or for 32 bit
+** counters may be a wrap (the previous value was near the top of the 32 bit range).
+*/
+
+unsigned long long counter_delta(unsigned long long prev, unsigned long long curr, int wrap32)
+{
+    const unsigned long long top32 = 0x100000000ULL;
+
+    if (curr >= prev)
+    	return curr - prev;
+
+    if (wrap32 == TRUE && prev < top32 && prev - curr > top32 / 2)
+    	return (top32 - prev) + curr;
+
+    return curr;
+}
+
+
+/* Local day number (for the daily totals) */
+
+int local_day(time_t t)
+{
+    struct tm tm;
+
+    localtime_r(&t, &tm);
+
+    return tm.tm_year * 400 + tm.tm_yday;
+}
+
+
+/* Today's totals from the ledger file */
+
+void load_today()
+{
+    size_t i, n;
+    char nm[LINK_NAME_SZ];
+    struct stat fileStat;
+    FileBuf fb;
+    LedgerRec *rec;
+    LedgerDev *ld;
+
+    if (stat(ldg_fn, &fileStat) < 0 || fileStat.st_size == 0)
+    	return;
+
+    if (map_file(ldg_fn, &fb) == FALSE)
+    	return;
+
+    /* Any partial record at the end is ignored */
+    n = fb.len / sizeof(LedgerRec);
+    rec = (LedgerRec *) fb.buf;
+
+    for(i = 0; i < n; i++, rec++)
+    {
+	if (rec->magic != LDG_MAGIC)
+	    continue;
+
+	if (local_day((time_t) rec->hour * 3600) != ldg_day)
+	    continue;
+
+	memcpy(nm, rec->name, LINK_NAME_SZ);
+	nm[LINK_NAME_SZ - 1] = '\0';
+	ld = ledger_dev(nm);
+	ld->rx_day += rec->rx_bytes;
+	ld->tx_day += rec->tx_bytes;
+    }
+
+    unmap_file(&fb);
+
+    return;
+}
+
+
+/*
+** Counters saved at the last write. If the system has not been restarted since, traffic
+** while the application was closed is counted from them. After a restart the counters
+** started again from 0.
+*/
+
+int load_state()
+{
+    int ifindex;
+    FILE *fd;
+    char id[40], nm[LINK_NAME_SZ];
+    unsigned long long rx, tx;
+    LedgerDev *ld;
+
+    if ((fd = fopen(st_fn, "r")) == NULL)
+    	return FALSE;
+
+    if (fscanf(fd, "%39s", id) != 1)
+    {
+	fclose(fd);
+	return FALSE;
+    }
+
+    while(fscanf(fd, "%15s %d %llu %llu", nm, &ifindex, &rx, &tx) == 4)
+    {
+	ld = ledger_dev(nm);
+	ld->seen = TRUE;
+
+	if (strcmp(id, boot_id) == 0)
+	{
+	    ld->ifindex = ifindex;
+	    ld->rx_last = rx;
+	    ld->tx_last = tx;
+	}
+	else
+	{
+	    ld->ifindex = 0;
+	    ld->rx_last = 0;
+	    ld->tx_last = 0;
+	}
+    }
+
+    fclose(fd);
+
+    return TRUE;
+}
+
+
+/* Save the counters last seen (written to a temporary file and renamed) */
+
+void save_state()
+{
+    int i;
+    FILE *fd;
+    char *tmp_fn;
+
+    tmp_fn = (char *) malloc(strlen(st_fn) + 5);
+    sprintf(tmp_fn, "%s.tmp", st_fn);
+
+    if ((fd = fopen(tmp_fn, "w")) == NULL)
+    {
+	free(tmp_fn);
+	return;
+    }
+
+    fprintf(fd, "%s\n", boot_id);
+
+    for(i = 0; i < ldg_cnt; i++)
+    {
+	if (ldg_devs[i].seen == TRUE)
+	    fprintf(fd, "%s %d %llu %llu\n", ldg_devs[i].name, ldg_devs[i].ifindex,
+	    				    ldg_devs[i].rx_last, ldg_devs[i].tx_last);
+    }
+
+    if (fclose(fd) == 0)
+	rename(tmp_fn, st_fn);
+    else
+	unlink(tmp_fn);
+
+    free(tmp_fn);
+
+    return;
+}
+
+
+/* Identifies the current boot of the system */
+
+void read_boot_id(char *id, int sz)
+{
+    int fd;
+    ssize_t n;
+
+    strcpy(id, "unknown");
+
+    if ((fd = open(BOOT_ID, O_RDONLY | O_CLOEXEC)) < 0)
+    	return;
+
+    if ((n = read(fd, id, sz - 1)) > 0)
+    {
+	id[n] = '\0';
+	id[strcspn(id, "\n")] = '\0';
+    }
+
+    close(fd);
+
+    return;
+}
@@ -26,6 +26,12 @@
 **
 ** History
 **	09-Jan-2017	Initial
+**	19-Oct-2026	Refresh timer is a scheduler job (no timer thread)
+**	19-Oct-2026	Chart image caches
+**	19-Oct-2026	History graph series toggles
+**	19-Oct-2026	Chart types (worker)
+**	19-Oct-2026	Warm start flag
+**	19-Oct-2026	New version text kept for the About panel (built on first view)
 **
 */
 
@@ -42,17 +48,25 @@
 /* Includes */
 
 #include <cairo_chart.h>
+#include <net_stats.h>
 
 
-/* Structure for main loop and data refresh timer */
+/* Scheduler jobs */
+
+#define SCHED_CONNECT 1
+#define SCHED_REFRESH 2
+#define SCHED_STATUS 3
+#define SCHED_VERSION 4
+#define HIST_CATS 5
+#define CHART_OVERVIEW 1
+#define CHART_HISTORY 2
+
+
+/* Structure for data refresh timer */
 
 typedef struct _refresh_tmr
 {
-    pthread_t refresh_tid;
-    guint tmr_id;
     int refresh_req;
-    time_t start_t;
-    time_t curr_t;
     long ref_interval;
     char info_txt[50];
 } RefreshTmr;
@@ -102,13 +116,15 @@ typedef struct _main_ui
     GtkWidget *sum_cntr, *graph_area;
     PieChart *pie_chart;
     BarChart *bar_chart;
+    ChartCache ov_cache;
 
     /* Widgets - history */
-    GtkWidget *from_dt_lbl, *to_dt_lbl, *cat_lbl, *hist_total;
+    GtkWidget *from_dt_lbl, *to_dt_lbl, *hist_total;
     GtkWidget *hist_from_dt, *hist_to_dt, *fr_btn, *to_btn;
-    GtkWidget *usgcat_cbox, *hist_search_btn;
+    GtkWidget *hist_series_chk[HIST_CATS], *hist_search_btn;
     GtkWidget *hist_search_cntr, *hist_graph_area;
     LineGraph *hist_usg_graph;
+    ChartCache hist_cache;
 
     /* Widgets - service plan */
     GtkWidget *plan_grid;
@@ -119,10 +135,15 @@ typedef struct _main_ui
     GtkWidget *new_vers_info;
 
     /* Widgets - monitor */
-    GtkWidget *log_cntr, *net_cntr;
+    GtkWidget *log_cntr, *net_cntr, *log_seg_cbox;
     GtkWidget *ip_addr, *mac_addr, *tx_bytes, *rx_bytes, *ndevs_cbox;
-    GtkWidget *rx_bar, *tx_bar;
-    GtkWidget *max_rxtx;
+    GtkWidget *rx_today, *tx_today;
+    GtkWidget *cap_chk;
+    GtkWidget *talk_host[TOP_TALKERS], *talk_port[TOP_TALKERS];
+    GtkWidget *talk_rx[TOP_TALKERS], *talk_tx[TOP_TALKERS];
+    GtkWidget *spark_area;
+    GtkWidget *rx_spd[RS_COLS], *tx_spd[RS_COLS];
+    GtkWidget *rate_grid, *agg_rx, *agg_tx;
     GList *ndevs;
 
     /* Widgets - preferences */
@@ -142,10 +163,18 @@ typedef struct _main_ui
 
     /* Misc */
     int duration, user_cd, ver_chk_flg;
+    int warm_start;
+    char new_vers[50];
     double rx1, tx1;
-    double sn_rx_kbps, sn_tx_kbps, max_kbps;
-    char *rxfn, *txfn;
+    long mon_intvl;
+    char mon_dev[16];
     double days_rem, days_quota;
     RefreshTmr RefTmr;
     pthread_t net_speed_tid;
+    unsigned int stats_seq;
+    int ui_pend;
+    gint64 ui_last;
+    DevStats *dev_stats;
+    int dev_cnt;
+    int net_mon_stop;
 } MainUi;
@@ -26,6 +26,10 @@
 **
 ** History
 **	09-Jan-2017	Initial code
+**	19-Oct-2026	Connect, refresh, countdown and version check are scheduler jobs
+**	19-Oct-2026	Adaptive refresh interval option
+**	19-Oct-2026	Show the last saved usage while connecting
+**	19-Oct-2026	Panels built the first time they are shown
 **
 */
 
@@ -43,7 +47,6 @@
 #include <libgen.h>  
 #include <gtk/gtk.h>  
 #include <gdk/gdkkeysyms.h>  
-#include <pthread.h>
 #include <main.h>
 #include <isp.h>
 #include <defs.h>
@@ -62,15 +65,18 @@ void create_label2(GtkWidget **, char *, char *, GtkWidget *);
 void create_entry(GtkWidget **, char *, GtkWidget *, int, int);
 void create_radio(GtkWidget **, GtkWidget *, char *, char *, GtkWidget *, int, char *, char *);
 void create_cbox(GtkWidget **, char *, const char *[], int, int, GtkWidget *, int, int);
-void show_panel(GtkWidget *, MainUi *); 
+void show_panel(GtkWidget **, MainUi *); 
+void build_panel(GtkWidget **, MainUi *); 
 void disable_login(MainUi *);
 void start_usage_mon(IspData *, MainUi *);
+int show_snapshot(IspData *, MainUi *);
+void drop_snapshot(MainUi *);
 void add_connect_loop(MainUi *);
-void add_main_loop(MainUi *);
-gboolean connect_main_loop_fn(gpointer);
-gboolean refresh_main_loop_fn(gpointer);
-int refresh_thread(MainUi *);
-void * timer_thread(void *);
+void connect_job(gpointer);
+void refresh_job(gpointer);
+void status_job(gpointer);
+void version_job(gpointer);
+int start_refresh(MainUi *);
 void set_retry_txt(MainUi *, char *, int);
 GtkWidget * debug_cntr(GtkWidget *);
 
@@ -90,6 +96,15 @@ extern void init_history(MainUi *);
 extern void set_css();
 extern int get_user_pref(char *, char **);
 extern int version_req_chk(IspData *, MainUi *);
+extern int sched_add(int, long, void (*)(gpointer), gpointer);
+extern gint64 sched_due(int);
+extern long adapt_interval(MainUi *, long);
+extern int snapshot_save(char *);
+extern int snapshot_load(time_t *);
+extern int snapshot_owner(char *);
+extern void snapshot_remove();
+extern int netdev_init(void (*)(gpointer), gpointer);
+extern void devs_changed(gpointer);
 
 extern void OnOverview(GtkWidget*, gpointer);
 extern void OnService(GtkWidget*, gpointer);
@@ -106,8 +121,8 @@ extern void OnOK(GtkRange*, gpointer);
 /* Globals */
 
 static const char *debug_hdr = "DEBUG-main_ui.c ";
-static const int main_loop_interval = 30;
-static int ret_mon;
+static const int ver_chk_delay = 30;		// Secs after start
+static const int msg_hold = 30;			// Secs any status message shows before the countdown
 
 
 /* Create the user interface and set the CallBacks */
@@ -154,9 +169,15 @@ void main_ui(IspData *isp_data, MainUi *m_ui)
     set_css();
     gtk_widget_show_all(m_ui->window);
 
-    /* Add an initial loop function to initiate connection */
-    show_panel(m_ui->mon_cntr, m_ui);
+    /* Network devices are found in the background */
+    netdev_init(devs_changed, m_ui);
+
+    /* Add an initial loop function to initiate connection (last usage saved or monitor shown meanwhile) */
     set_connect_btns(m_ui, FALSE);
+
+    if (show_snapshot(isp_data, m_ui) == FALSE)
+	show_panel(&(m_ui->mon_cntr), m_ui);
+
     add_connect_loop(m_ui);
 
     return;
@@ -243,19 +264,11 @@ void create_main_view(MainUi *m_ui)
     /* Usage button panel */
     usage_btns(m_ui);
 
-    /* Stack widget to attach the different panels to */
+    /* Stack widget to attach the different panels to (each built the first time it is shown) */
     m_ui->panel_stk = gtk_stack_new();
     gtk_stack_set_homogeneous(GTK_STACK (m_ui->panel_stk), TRUE);
     gtk_stack_set_transition_type (GTK_STACK (m_ui->panel_stk), GTK_STACK_TRANSITION_TYPE_NONE); 
 
-    /* Usage panels */
-    overview_panel(m_ui);
-    serv_plan_panel(m_ui);
-    monitor_panel(m_ui);
-    history_panel(m_ui);
-    pref_panel(m_ui);
-    about_panel(m_ui);
-
     /* Combine everything onto the main view */
     gtk_box_pack_start (GTK_BOX (m_ui->ctrl_box), m_ui->btn_panel, FALSE, FALSE, 0);
     gtk_box_pack_start (GTK_BOX (m_ui->ctrl_box), m_ui->panel_stk, TRUE, TRUE, 0);
@@ -344,16 +357,58 @@ void set_connect_btns(MainUi *m_ui, int sens)
 }
 
 
-/* Maintain which panel is visible */
+/* Maintain which panel is visible. The panel container is passed so it may be built first */
 
-void show_panel(GtkWidget *cntr, MainUi *m_ui) 
+void show_panel(GtkWidget **cntr, MainUi *m_ui) 
 {
-    if (cntr == m_ui->curr_panel)
+    if (*cntr == NULL)
+    	build_panel(cntr, m_ui);
+
+    if (*cntr == m_ui->curr_panel)
     	return;
 
-    gtk_stack_set_visible_child (GTK_STACK (m_ui->panel_stk), cntr);
+    gtk_stack_set_visible_child (GTK_STACK (m_ui->panel_stk), *cntr);
+
+    m_ui->curr_panel = *cntr;
+
+    return;
+}
+
+
+/* Build a panel and bring it up to date with anything that happened before it existed */
+
+void build_panel(GtkWidget **cntr, MainUi *m_ui) 
+{
+    if (cntr == &(m_ui->oview_cntr))
+    {
+	overview_panel(m_ui);
+    }
+    else if (cntr == &(m_ui->srv_cntr))
+    {
+	serv_plan_panel(m_ui);
+	serv_plan_details(TRUE, m_ui);
+    }
+    else if (cntr == &(m_ui->mon_cntr))
+    {
+	monitor_panel(m_ui);
+    }
+    else if (cntr == &(m_ui->hist_cntr))
+    {
+	history_panel(m_ui);
+    }
+    else if (cntr == &(m_ui->pref_cntr))
+    {
+	pref_panel(m_ui);
+
+	if (gtk_widget_get_sensitive (m_ui->user_login) == FALSE)
+	    disable_login(m_ui);
+    }
+    else if (cntr == &(m_ui->about_cntr))
+    {
+	about_panel(m_ui);
+    }
 
-    m_ui->curr_panel = cntr;
+    gtk_widget_show_all (*cntr);
 
     return;
 }
@@ -468,7 +523,7 @@ void disable_login(MainUi *m_ui)
 {  
     gtk_widget_set_sensitive (m_ui->user_login, FALSE);
 
-    if (m_ui->user_cd == FALSE)
+    if (m_ui->user_cd == FALSE && m_ui->reset_pw_btn != NULL)
     	gtk_widget_set_sensitive (m_ui->reset_pw_btn, FALSE);
 
 
@@ -480,46 +535,85 @@ void disable_login(MainUi *m_ui)
 
 void start_usage_mon(IspData *isp_data, MainUi *m_ui)
 {  
+    snapshot_save(isp_data->uname);
     set_connect_btns(m_ui, TRUE);
     disable_login(m_ui);
-    serv_plan_details(TRUE, m_ui);
+    serv_plan_details(FALSE, m_ui);
+    show_panel(&(m_ui->oview_cntr), m_ui);
     load_overview(isp_data, m_ui);
-    show_panel(m_ui->oview_cntr, m_ui);
 
-    if (refresh_thread(m_ui) == TRUE)
-	add_main_loop(m_ui);
+    start_refresh(m_ui);
+    sched_add(SCHED_VERSION, ver_chk_delay * 1000, version_job, m_ui);
 
     return;
 }
 
 
-// Inject a main loop timer to initiate isp connection.
-// Required as main loop needs to be started in case of an error. */
+/* Show the usage saved at the last start or refresh (if any) until the connection is made */
 
-void add_connect_loop(MainUi *m_ui)
+int show_snapshot(IspData *isp_data, MainUi *m_ui)
 {  
-    g_timeout_add(1, connect_main_loop_fn, m_ui);
+    long mins;
+    time_t saved_t;
+    char s[100];
 
-    /* Appears to need a short delay to avoid bus connection error - for main loop to start? */
-    usleep(5);
+    if (snapshot_load(&saved_t) == FALSE)
+    	return FALSE;
+
+    m_ui->warm_start = TRUE;
+    set_connect_btns(m_ui, TRUE);
+    show_panel(&(m_ui->oview_cntr), m_ui);
+    load_overview(isp_data, m_ui);
+
+    /* Make it plain the details are not current */
+    mins = (long) (difftime(time(NULL), saved_t) / 60);
+
+    if (mins < 60)
+	sprintf(s, "Last saved usage (%ld min ago) - connecting...", (mins < 0) ? 0 : mins);
+    else if (mins < 2880)
+	sprintf(s, "Last saved usage (%ld hours ago) - connecting...", mins / 60);
+    else
+	sprintf(s, "Last saved usage (%ld days ago) - connecting...", mins / 1440);
+
+    gtk_label_set_text (GTK_LABEL (m_ui->status_info), s);
+
+    return TRUE;
+}
+
+
+/* Take down the saved usage shown (not for the current account) */
+
+void drop_snapshot(MainUi *m_ui)
+{  
+    snapshot_remove();
+
+    m_ui->warm_start = FALSE;
+    set_connect_btns(m_ui, FALSE);
+    show_panel(&(m_ui->mon_cntr), m_ui);
+    gtk_label_set_text (GTK_LABEL (m_ui->status_info), " ");
 
     return;
 }
 
 
-/* Inject a main loop timer */
+// Schedule a job to initiate isp connection.
+// Required as main loop needs to be started in case of an error. When saved usage is
+// shown the connection waits a little so the window is drawn first. */
 
-void add_main_loop(MainUi *m_ui)
+void add_connect_loop(MainUi *m_ui)
 {  
-    m_ui->RefTmr.tmr_id = g_timeout_add_seconds(main_loop_interval, refresh_main_loop_fn, m_ui);
+    sched_add(SCHED_CONNECT, (m_ui->warm_start == TRUE) ? 250 : 1, connect_job, m_ui);
+
+    /* Appears to need a short delay to avoid bus connection error - for main loop to start? */
+    usleep(5);
 
     return;
 }
 
 
-/* Main loop timer function for isp connection */
+/* Scheduled job for isp connection */
 
-gboolean connect_main_loop_fn(gpointer user_data)
+void connect_job(gpointer user_data)
 {
     int login_req, r;
     MainUi *m_ui;
@@ -539,6 +633,10 @@ gboolean connect_main_loop_fn(gpointer user_data)
     }
     else
     {
+	/* Saved usage for another account is not shown */
+	if (m_ui->warm_start == TRUE && snapshot_owner(isp_data->uname) == FALSE)
+	    drop_snapshot(m_ui);
+
 	/* Initiate a service request */
 	r = ssl_service_details(isp_data, m_ui);
 	
@@ -548,8 +646,8 @@ gboolean connect_main_loop_fn(gpointer user_data)
 	}
 	else if (r == FALSE)
 	{
-	    g_timeout_add_seconds(60, connect_main_loop_fn, m_ui);
-	    return FALSE;
+	    sched_add(SCHED_CONNECT, 60000, connect_job, m_ui);
+	    return;
 	}
     }
 
@@ -559,16 +657,14 @@ gboolean connect_main_loop_fn(gpointer user_data)
     else
 	start_usage_mon(isp_data, m_ui);
 
-    /* Return False destroys the loop function */
-    return FALSE;
+    return;
 }
 
 
-/* Main loop timer function to check for data refresh */
+/* Scheduled job for a data refresh */
 
-gboolean refresh_main_loop_fn(gpointer user_data)
+void refresh_job(gpointer user_data)
 {
-    int login_req, r;
     MainUi *m_ui;
     IspData *isp_data;
     RefreshTmr *ref_tmr;
@@ -578,104 +674,107 @@ gboolean refresh_main_loop_fn(gpointer user_data)
     ref_tmr = &(m_ui->RefTmr);
     isp_data = (IspData *) g_object_get_data (G_OBJECT (m_ui->window), "isp_data");
 
+    ref_tmr->refresh_req = TRUE;
+    sprintf(ref_tmr->info_txt, "Refreshing usage details...");
     gtk_label_set_text (GTK_LABEL (m_ui->status_info), ref_tmr->info_txt);
     gtk_widget_show (m_ui->status_info);
 
-    /* One-off new version check */
-    version_req_chk(isp_data, m_ui);
-
-    /* Check refresh required */
-    if (ref_tmr->refresh_req == FALSE)
-    	return TRUE;
-
-    /* Reset usage data */
-    if (ssl_service_details(isp_data, m_ui) != TRUE)
+    /* Reset usage data (on error try again at the next refresh) */
+    if (ssl_service_details(isp_data, m_ui) == TRUE)
     {
-	refresh_thread(m_ui);
-    	return TRUE;
+	snapshot_save(isp_data->uname);
+	serv_plan_details(FALSE, m_ui);
+	init_history(m_ui);
+	load_overview(isp_data, m_ui);
     }
 
-    serv_plan_details(FALSE, m_ui);
+    start_refresh(m_ui);
 
-    init_history(m_ui);
-    load_overview(isp_data, m_ui);
-    refresh_thread(m_ui);
+    return;
+}
 
-    return TRUE;
+
+/* Scheduled job to show the time to the next refresh. Runs only when the minutes shown change */
+
+void status_job(gpointer user_data)
+{
+    int mins;
+    gint64 due, now, next;
+    MainUi *m_ui;
+    RefreshTmr *ref_tmr;
+
+    /* Initial */
+    m_ui = (MainUi *) user_data;
+    ref_tmr = &(m_ui->RefTmr);
+
+    if ((due = sched_due(SCHED_REFRESH)) < 0)
+    	return;
+
+    now = g_get_monotonic_time();
+    mins = (int) (((due - now) / 60000000.0) + 0.5);
+
+    if (mins <= 0)
+    	return;
+
+    if (mins == 1)
+	sprintf(ref_tmr->info_txt, "Next refresh due in %d minute", mins);
+    else
+	sprintf(ref_tmr->info_txt, "Next refresh due in %d minutes", mins);
+
+    gtk_label_set_text (GTK_LABEL (m_ui->status_info), ref_tmr->info_txt);
+    gtk_widget_show (m_ui->status_info);
+
+    /* The rounded minutes drop by one at half a minute past each whole minute to go */
+    next = due - ((gint64) mins * 60000000) + 30000000;
+    sched_add(SCHED_STATUS, (long) ((next - now) / 1000) + 1, status_job, m_ui);
+
+    return;
+}
+
+
+/* Scheduled job for the one-off new version check (retried at the refresh interval) */
+
+void version_job(gpointer user_data)
+{
+    MainUi *m_ui;
+    IspData *isp_data;
+
+    m_ui = (MainUi *) user_data;
+    isp_data = (IspData *) g_object_get_data (G_OBJECT (m_ui->window), "isp_data");
+
+    if (version_req_chk(isp_data, m_ui) == FALSE)
+	sched_add(SCHED_VERSION, m_ui->RefTmr.ref_interval * 1000, version_job, m_ui);
+
+    return;
 }
 
 
-/* Start the refresh timer thread and set the start time */
+/* Schedule the next data refresh and the countdown display */
 
-int refresh_thread(MainUi *m_ui)
+int start_refresh(MainUi *m_ui)
 {  
-    int p_err;
     char *p;
 
     /* Initial timer setup */
     m_ui->RefTmr.refresh_req = FALSE;
-    m_ui->RefTmr.start_t = time(NULL);
     get_user_pref(REFRESH_TM, &p);
     m_ui->RefTmr.ref_interval = atol(p) * 60;
 
-    /* Start thread */
-    if ((p_err = pthread_create(&(m_ui->RefTmr.refresh_tid), NULL, &timer_thread, (void *) m_ui)) != 0)
-    {
-	sprintf(app_msg_extra, "Error: %s", strerror(p_err));
-	log_msg("ERR0044", NULL, "ERR0044", m_ui->window);
-	return FALSE;
-    }
-
-    return TRUE;
-}
+    if (m_ui->RefTmr.ref_interval < 60)
+    	m_ui->RefTmr.ref_interval = 60;
 
+    /* Adaptive - sooner as a quota threshold or rollover nears */
+    get_user_pref(REFRESH_MODE, &p);
 
-/* Refresh timer thread */
-
-void * timer_thread(void *arg)
-{  
-    int mins;
-    time_t ref_t;
-    MainUi *m_ui;
-    RefreshTmr *ref_tmr;
-
-    /* Initial */
-    m_ui = (MainUi *) arg;
-    ref_tmr = &(m_ui->RefTmr);
-    ref_t = ref_tmr->start_t + ref_tmr->ref_interval;
+    if (p != NULL && strcmp(p, "1") == 0)
+	m_ui->RefTmr.ref_interval = adapt_interval(m_ui, m_ui->RefTmr.ref_interval);
 
-    /* Get time */
-    while(1)
-    {
-	ref_tmr->curr_t = time(NULL);
-	mins = (int) (((ref_t - ref_tmr->curr_t) / 60.0) + 0.5);
+    if (sched_add(SCHED_REFRESH, m_ui->RefTmr.ref_interval * 1000, refresh_job, m_ui) == FALSE)
+	return FALSE;
 
-	/* Set info text */
-	if (mins == 0)
-	{
-	    sprintf(ref_tmr->info_txt, "Refreshing usage details...");
-	    ref_tmr->refresh_req = TRUE;
-	    break;
-	}
-	else
-	{
-	    if (mins == 1)
-		sprintf(ref_tmr->info_txt, "Next refresh due in %d minute", mins);
-	    else
-		sprintf(ref_tmr->info_txt, "Next refresh due in %d minutes", mins);
-	}
+    sched_add(SCHED_STATUS, msg_hold * 1000, status_job, m_ui);
 
-	sleep(15);
-    }
-    
-    pthread_exit(&ret_mon);
-
-/* Debug
-printf("%s timer thread start\n", debug_hdr); fflush(stdout);
-printf("%s timer thread start: %ld, current: %ld, interval %ld\n", 
-    debug_hdr, ref_tmr->start_t, ref_tmr->curr_t, ref_tmr->ref_interval); fflush(stdout);
-printf("%s timer thread exit\n", debug_hdr); fflush(stdout);
-*/
+    return TRUE;
 }
 
 
@@ -26,6 +26,18 @@
 **
 ** History
 **	10-Jul-2017	Initial code
+**	19-Oct-2026	Log segment (archive) selection
+**	19-Oct-2026	Keep the device counter files open while a device is selected
+**	19-Oct-2026	Counters for all links from one netlink query (replaces the /sys files)
+**	19-Oct-2026	One sampler thread for all devices and a table of rates
+**	19-Oct-2026	Monotonic sample times, sample ring per device and a sparkline
+**	19-Oct-2026	Sampler publishes under a sequence count, display updates are coalesced
+**	19-Oct-2026	Averages, peak and percentile speeds for the selected device
+**	19-Oct-2026	Today's totals from the traffic ledger
+**	19-Oct-2026	Top talkers from an optional packet capture
+**	19-Oct-2026	Device list from the netlink interface cache, updated as devices change
+**	19-Oct-2026	Panel built on first view, devices may still be being found
+**	19-Oct-2026	Device events only touch the rows (and stats) of devices that come or go
 **
 */
 
@@ -43,10 +55,12 @@
 #include <gtk/gtk.h>  
 #include <unistd.h>
 #include <sys/types.h>
-#include <sys/sysinfo.h>
-#include <pcap.h> 
+#include <sys/stat.h>
+#include <time.h>
+#include <arpa/inet.h>
 #include <errno.h>
 #include <main.h>
+#include <net_stats.h>
 #include <defs.h>
 #include <version.h>
 
@@ -57,6 +71,7 @@ typedef struct _net_device {
     char *name;
     char ip[16];
     unsigned char mac[18];
+    GtkWidget *rx_lbl, *tx_lbl;
 } NetDevice;
 
 
@@ -64,43 +79,81 @@ typedef struct _net_device {
 
 void monitor_panel(MainUi *m_ui);
 GtkWidget * monitor_log(MainUi *m_ui);
+void load_log_segments(MainUi *);
 GtkWidget * monitor_net(MainUi *m_ui);
 GList * get_netdevices(MainUi *);
 void get_net_details(MainUi *);
+void load_net_devs(MainUi *);
+void devs_changed(gpointer);
+int same_devs(GList *, GList *);
+NetDevice * find_dev(GList *, char *);
+void show_dev_addr(MainUi *);
 NetDevice * new_dev();
 void free_dev(void *);
+void set_rate_table(MainUi *);
+void update_rate_table(MainUi *, GList *);
+void init_dev_stats(DevStats *, char *, MainUi *);
 int monitor_device(MainUi *);
+int start_net_mon(MainUi *);
+void stop_net_mon(MainUi *);
 void * net_speed(void *);
-void reset_fn(MainUi *);
-int network_totals(char *, char *, char *, char *, const int);
+void sample_devices(double, MainUi *);
+void post_net_rates(MainUi *);
+gboolean show_net_rates(gpointer);
+int read_net_rates(MainUi *, double *, double *, int *, int, RateStats *);
+void show_rate_stats(MainUi *, RateStats *, double, double);
+void free_dev_stats(MainUi *);
+int network_totals(char *, char *, char *, const int);
 void session_stats(char *, char *, double *, double *, MainUi *);
-void display_speed(GtkWidget *, double, double, double, double *, GtkWidget *);
-int session_speed(MainUi *);
+void today_stats(char *, RateSample *, MainUi *);
+void show_talkers(MainUi *);
+void draw_sparkline(cairo_t *, GtkAllocation *, MainUi *);
+DevStats * selected_dev(MainUi *);
+void ring_init(SampleRing *, unsigned long);
+void ring_free(SampleRing *);
+void ring_put(SampleRing *, RateSample *);
+unsigned long ring_count(SampleRing *);
+int ring_rate(SampleRing *, unsigned long, double *, double *, double *);
+int ring_last(SampleRing *, RateSample *);
+double mono_time();
+long mon_pref(char *, long, long);
 void bps_abbrev(double, double *, char *);
 
 extern char * log_name();
+extern char * log_segment(int);
 extern void log_msg(char*, char*, char*, GtkWidget*);
-extern int ip_address(char *, char [16], unsigned char [13]);
+extern int netdev_ready();
+extern int netdev_list(IfEntry **);
+extern int netdev_active(IfEntry *);
 extern void create_label(GtkWidget **, char *, char *, GtkWidget *, int, int, int, int);
 extern void create_entry(GtkWidget **, char *, GtkWidget *, int, int);
 extern void set_sz_abbrev(char *);
-extern FILE * open_file(char *, char *);
-extern int read_file(FILE *, char *, int);
+extern int link_stats(LinkStats **, int *);
+extern int ledger_today(char *, unsigned long long, unsigned long long, unsigned long long *, unsigned long long *);
+extern int rate_stats_init(RateStats *, double);
+extern void rate_stats_free(RateStats *);
+extern void rate_stats_add(RateStats *, double, double, double);
+extern int get_user_pref(char *, char **);
+extern gboolean OnSparkExpose(GtkWidget *, cairo_t *, gpointer);
 extern int check_errno();
 extern void OnViewLog(GtkWidget*, gpointer);
 extern void OnSetNetDev(GtkWidget*, gpointer);
+extern void OnCapture(GtkToggleButton*, gpointer);
+extern int start_capture(char *, GtkWidget *);
+extern int capture_active();
+extern int capture_top(FlowEntry *, int);
 
 
 /* Globals */
 
 static const char *debug_hdr = "DEBUG-monitor.c ";
-static const char *rtx_bytes_pfx = "/sys/class/net/";
-static const char *rx_bytes_sfx = "/statistics/rx_bytes";
-static const char *tx_bytes_sfx = "/statistics/tx_bytes";
-static const int tx_rx_len = 35;
 static const int fsz = 30;		// Max size allowed
 const double kbps_dv = 128.0;		// 1024.0/8.0
 static int net_mon;
+static int devs_loaded = FALSE;
+static int devs_pend = FALSE;
+static const int ui_min_ms = 250;	// Fastest rate display update
+static const char *spd_hdg[] = { "Now", "Avg 10s", "Avg 1m", "p50", "p95", "p99", "Peak" };
 
 
 
@@ -163,11 +216,17 @@ GtkWidget * monitor_log(MainUi *m_ui)
 
     gtk_widget_set_margin_start(label_fn, 5);
 
+    /* Log segment (current or an archive) */
+    m_ui->log_seg_cbox = gtk_combo_box_text_new();
+    gtk_widget_set_margin_start (m_ui->log_seg_cbox, 5);
+    gtk_grid_attach(GTK_GRID (log_grid), m_ui->log_seg_cbox, 1, 0, 1, 1);
+    load_log_segments(m_ui);
+
     /* View button */
     view_btn = gtk_button_new_with_label("View");
     gtk_widget_set_margin_start(view_btn, 5);
     gtk_widget_set_halign (view_btn, GTK_ALIGN_END);
-    gtk_grid_attach(GTK_GRID (log_grid), view_btn, 1, 0, 1, 1);
+    gtk_grid_attach(GTK_GRID (log_grid), view_btn, 2, 0, 1, 1);
 
     /* Pack */
     gtk_container_add(GTK_CONTAINER (frame), log_grid);
@@ -179,12 +238,47 @@ GtkWidget * monitor_log(MainUi *m_ui)
 }
 
 
+/* List the current log and any archived (compressed) log segments available for viewing */
+
+void load_log_segments(MainUi *m_ui)
+{  
+    int i;
+    char *fn;
+    char id[10];
+    char txt[40];
+    char dt[20];
+    struct stat fileStat;
+
+    gtk_combo_box_text_remove_all (GTK_COMBO_BOX_TEXT (m_ui->log_seg_cbox));
+    gtk_combo_box_text_append (GTK_COMBO_BOX_TEXT (m_ui->log_seg_cbox), "0", "Current");
+
+    for(i = 1; (fn = log_segment(i)) != NULL; i++)
+    {
+	if (stat(fn, &fileStat) == 0)
+	{
+	    strftime(dt, sizeof(dt), "%d-%b-%Y", localtime(&fileStat.st_mtime));
+	    sprintf(txt, "Archive %d (%s)", i, dt);
+	    sprintf(id, "%d", i);
+	    gtk_combo_box_text_append (GTK_COMBO_BOX_TEXT (m_ui->log_seg_cbox), id, txt);
+	}
+
+	free(fn);
+    }
+
+    gtk_combo_box_set_active (GTK_COMBO_BOX (m_ui->log_seg_cbox), 0);
+
+    return;
+}
+
+
 /* Network traffic details and monitoring */
 
 GtkWidget * monitor_net(MainUi *m_ui)
 {  
-    GtkWidget *frame, *frame2;
-    GtkWidget *vbox, *bar_grid, *dev_grid, *stat_grid;
+    int i;
+    GtkWidget *frame, *frame2, *frame3, *frame4;
+    GtkWidget *talk_grid;
+    GtkWidget *vbox, *bar_grid, *dev_grid, *stat_grid, *spd_grid;
     GtkWidget *lbl;
 
     /* Containers */
@@ -220,9 +314,13 @@ GtkWidget * monitor_net(MainUi *m_ui)
     create_label(&(m_ui->rx_bytes), "data_1", "", stat_grid, 1, 0, 1, 1);
     create_label(&lbl, "txlbl", "TX bytes this session: ", stat_grid, 0, 1, 1, 1);
     create_label(&(m_ui->tx_bytes), "data_1", "", stat_grid, 1, 1, 1, 1);
+    create_label(&lbl, "rxlbl", "RX bytes today: ", stat_grid, 0, 2, 1, 1);
+    create_label(&(m_ui->rx_today), "data_1", "", stat_grid, 1, 2, 1, 1);
+    create_label(&lbl, "txlbl", "TX bytes today: ", stat_grid, 0, 3, 1, 1);
+    create_label(&(m_ui->tx_today), "data_1", "", stat_grid, 1, 3, 1, 1);
 
     /* Network speed frame */
-    frame2 = gtk_frame_new("Network speed (approx.)");
+    frame2 = gtk_frame_new("Network speed");
     gtk_widget_set_margin_top (frame2, 10);
     gtk_widget_set_margin_bottom (frame2, 10);
     gtk_widget_set_margin_start (frame2, 10);
@@ -234,43 +332,96 @@ GtkWidget * monitor_net(MainUi *m_ui)
     gtk_grid_set_column_spacing(GTK_GRID (bar_grid), 2);
     gtk_widget_set_margin_start (bar_grid, 20);
 
-    /* Network speed progress bars */
-    create_label(&lbl, "barrxbl", "RX:", bar_grid, 0, 0, 1, 1);
-    create_label(&lbl, "bartxbl", "TX:", bar_grid, 0, 1, 1, 1);
-    create_label(&(m_ui->max_rxtx), "data_3", "", bar_grid, 1, 2, 1, 1);
-    gtk_widget_set_margin_bottom (m_ui->max_rxtx, 3);
-    gtk_widget_set_halign (m_ui->max_rxtx, GTK_ALIGN_CENTER);
-
-    m_ui->rx_bar = gtk_progress_bar_new();
-    gtk_progress_bar_set_show_text (GTK_PROGRESS_BAR (m_ui->rx_bar), TRUE);
-    gtk_widget_set_name (m_ui->rx_bar, "pbar_1");
-    gtk_widget_set_margin_bottom (m_ui->rx_bar, 5);
-    gtk_widget_set_margin_start (m_ui->rx_bar, 10);
-    gtk_widget_set_margin_end (m_ui->rx_bar, 5);
-
-    m_ui->tx_bar = gtk_progress_bar_new();
-    gtk_progress_bar_set_show_text (GTK_PROGRESS_BAR (m_ui->tx_bar), TRUE);
-    gtk_widget_set_name (m_ui->tx_bar, "pbar_1");
-    gtk_widget_set_margin_bottom (m_ui->tx_bar, 3);
-    gtk_widget_set_margin_start (m_ui->tx_bar, 10);
-    gtk_widget_set_margin_end (m_ui->tx_bar, 5);
-
-    gtk_grid_attach(GTK_GRID (bar_grid), m_ui->rx_bar, 1, 0, 1, 1);
-    gtk_grid_attach(GTK_GRID (bar_grid), m_ui->tx_bar, 1, 1, 1, 1);
+    /* Network speed sparkline (RX and TX history for the selected device) */
+    m_ui->spark_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request (m_ui->spark_area, 300, 60);
+    gtk_widget_set_hexpand (m_ui->spark_area, TRUE);
+    gtk_widget_set_margin_top (m_ui->spark_area, 5);
+    gtk_widget_set_margin_end (m_ui->spark_area, 10);
+    gtk_grid_attach(GTK_GRID (bar_grid), m_ui->spark_area, 0, 0, 1, 1);
+
+    /* Speed statistics for the selected device */
+    spd_grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID (spd_grid), 2);
+    gtk_grid_set_column_spacing(GTK_GRID (spd_grid), 12);
+    gtk_widget_set_margin_top (spd_grid, 5);
+    gtk_widget_set_margin_bottom (spd_grid, 5);
+
+    for(i = 0; i < RS_COLS; i++)
+	create_label(&lbl, "title_4", (char *) spd_hdg[i], spd_grid, i + 1, 0, 1, 1);
+
+    create_label(&lbl, "title_4", "RX", spd_grid, 0, 1, 1, 1);
+    create_label(&lbl, "title_4", "TX", spd_grid, 0, 2, 1, 1);
+
+    for(i = 0; i < RS_COLS; i++)
+    {
+	create_label(&(m_ui->rx_spd[i]), "data_3", "", spd_grid, i + 1, 1, 1, 1);
+	create_label(&(m_ui->tx_spd[i]), "data_3", "", spd_grid, i + 1, 2, 1, 1);
+    }
+
+    gtk_grid_attach(GTK_GRID (bar_grid), spd_grid, 0, 1, 1, 1);
     gtk_container_add(GTK_CONTAINER (frame2), bar_grid);
 
+    /* All devices - rows are added when the device list is loaded */
+    frame3 = gtk_frame_new("All devices");
+    gtk_widget_set_margin_bottom (frame3, 10);
+    gtk_widget_set_margin_start (frame3, 10);
+    gtk_widget_set_margin_end (frame3, 10);
+
+    m_ui->rate_grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID (m_ui->rate_grid), 2);
+    gtk_grid_set_column_spacing(GTK_GRID (m_ui->rate_grid), 20);
+    gtk_widget_set_margin_start (m_ui->rate_grid, 20);
+    gtk_widget_set_margin_bottom (m_ui->rate_grid, 5);
+    gtk_container_add(GTK_CONTAINER (frame3), m_ui->rate_grid);
+
+    /* Top talkers (packet capture on the selected device, off by default) */
+    frame4 = gtk_frame_new("Top talkers");
+    gtk_widget_set_margin_bottom (frame4, 10);
+    gtk_widget_set_margin_start (frame4, 10);
+    gtk_widget_set_margin_end (frame4, 10);
+
+    talk_grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID (talk_grid), 2);
+    gtk_grid_set_column_spacing(GTK_GRID (talk_grid), 20);
+    gtk_widget_set_margin_start (talk_grid, 20);
+    gtk_widget_set_margin_bottom (talk_grid, 5);
+
+    m_ui->cap_chk = gtk_check_button_new_with_label("Capture packets (needs root or CAP_NET_RAW)");
+    gtk_grid_attach(GTK_GRID (talk_grid), m_ui->cap_chk, 0, 0, 4, 1);
+
+    create_label(&lbl, "title_4", "Remote host", talk_grid, 0, 1, 1, 1);
+    create_label(&lbl, "title_4", "Port", talk_grid, 1, 1, 1, 1);
+    create_label(&lbl, "title_4", "RX", talk_grid, 2, 1, 1, 1);
+    create_label(&lbl, "title_4", "TX", talk_grid, 3, 1, 1, 1);
+
+    for(i = 0; i < TOP_TALKERS; i++)
+    {
+	create_label(&(m_ui->talk_host[i]), "data_1", "", talk_grid, 0, i + 2, 1, 1);
+	create_label(&(m_ui->talk_port[i]), "data_1", "", talk_grid, 1, i + 2, 1, 1);
+	create_label(&(m_ui->talk_rx[i]), "data_1", "", talk_grid, 2, i + 2, 1, 1);
+	create_label(&(m_ui->talk_tx[i]), "data_1", "", talk_grid, 3, i + 2, 1, 1);
+    }
+
+    gtk_container_add(GTK_CONTAINER (frame4), talk_grid);
+
     /* Pack */
     gtk_box_pack_start (GTK_BOX (vbox), m_ui->ndevs_cbox, FALSE, FALSE, 0);
     gtk_box_pack_start (GTK_BOX (vbox), dev_grid, FALSE, FALSE, 0);
     gtk_box_pack_start (GTK_BOX (vbox), stat_grid, FALSE, FALSE, 0);
     gtk_box_pack_start (GTK_BOX (vbox), frame2, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (vbox), frame3, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (vbox), frame4, FALSE, FALSE, 0);
     gtk_container_add(GTK_CONTAINER (frame), vbox);
 
     /* Callback */
     m_ui->dvcbx_hndlr_id = g_signal_connect(m_ui->ndevs_cbox, "changed", G_CALLBACK(OnSetNetDev), m_ui);
+    g_signal_connect (G_OBJECT (m_ui->spark_area), "draw", G_CALLBACK (OnSparkExpose), m_ui);
+    g_signal_connect (G_OBJECT (m_ui->cap_chk), "toggled", G_CALLBACK (OnCapture), m_ui);
 
     /* Inits */
-    m_ui->max_kbps = 0.0;
+    m_ui->stats_seq = 0;
+    m_ui->ui_pend = FALSE;
 
     return frame;
 }
@@ -280,99 +431,360 @@ GtkWidget * monitor_net(MainUi *m_ui)
 
 void get_net_details(MainUi *m_ui)
 {  
-    GList *l;
-    NetDevice *dev;
+    /* Devices are still being found - carry on when they are (devs_changed) */
+    if (netdev_ready() == FALSE)
+    {
+	devs_pend = TRUE;
+	return;
+    }
+
+    /* The list is kept current by device events, so only load it the first time */
+    if (m_ui->ndevs == NULL)
+    	load_net_devs(m_ui);
+
+    if (m_ui->ndevs == NULL)
+    {
+	sprintf(app_msg_extra, "No active, working devices found.");
+	log_msg("ERR0047", NULL, "ERR0047", m_ui->window);
+	return;
+    }
+
+    start_net_mon(m_ui);
+
+    return;
+}
+
+
+/* Device list has changed (netlink event) */
+
+void devs_changed(gpointer user_data)
+{  
+    MainUi *m_ui;
+
+    m_ui = (MainUi *) user_data;
+
+    /* Monitor shown before the devices were found */
+    if (devs_pend == TRUE)
+    {
+	devs_pend = FALSE;
+	get_net_details(m_ui);
+	return;
+    }
+
+    /* Nothing to do until the monitor has been shown */
+    if (devs_loaded == FALSE)
+    	return;
+
+    load_net_devs(m_ui);
+
+    return;
+}
+
+
+/*
+** (Re)build the device list, combo and rates table keeping the current selection if possible.
+** Most events (address lifetimes, state flaps) leave the same devices, so then only the
+** addresses are refreshed and the sampler and its statistics are left alone.
+*/
+
+void load_net_devs(MainUi *m_ui)
+{  
+    int running;
+    GList *l, *new_devs;
+    NetDevice *dev, *ndev;
     
-    /* Device list can be dynamic so reset every time */
-    g_signal_handler_block (m_ui->ndevs_cbox, m_ui->dvcbx_hndlr_id);
-    gtk_combo_box_text_remove_all (GTK_COMBO_BOX_TEXT (m_ui->ndevs_cbox));
-    g_signal_handler_unblock (m_ui->ndevs_cbox, m_ui->dvcbx_hndlr_id);
+    new_devs = get_netdevices(m_ui);
+    devs_loaded = TRUE;
 
-    g_list_free_full (m_ui->ndevs, (GDestroyNotify) free_dev);
+    /* Same devices */
+    if (m_ui->ndevs != NULL && same_devs(m_ui->ndevs, new_devs) == TRUE)
+    {
+	for(l = m_ui->ndevs; l != NULL; l = l->next)
+	{
+	    dev = (NetDevice *) l->data;
+	    ndev = find_dev(new_devs, dev->name);
+	    strcpy(dev->ip, ndev->ip);
+	    strcpy((char *) dev->mac, (char *) ndev->mac);
+	}
+
+	g_list_free_full (new_devs, (GDestroyNotify) free_dev);
+
+	if (m_ui->mon_dev[0] != '\0')
+	    show_dev_addr(m_ui);
+
+	return;
+    }
+
+    running = (m_ui->net_speed_tid != 0);
 
-    /* New list */
-    m_ui->ndevs = get_netdevices(m_ui);
+    /* Rates for all devices (stops the sampler) */
+    if (m_ui->ndevs == NULL)
+    {
+	m_ui->ndevs = new_devs;
+	set_rate_table(m_ui);
+    }
+    else
+    {
+	update_rate_table(m_ui, new_devs);
+    }
 
     /* Set combo box */
+    g_signal_handler_block (m_ui->ndevs_cbox, m_ui->dvcbx_hndlr_id);
+    gtk_combo_box_text_remove_all (GTK_COMBO_BOX_TEXT (m_ui->ndevs_cbox));
+
     for(l = m_ui->ndevs; l != NULL; l = l->next)
     {
     	dev = (NetDevice *) l->data;
     	gtk_combo_box_text_append (GTK_COMBO_BOX_TEXT (m_ui->ndevs_cbox), dev->name, dev->name);
     }
 
-    gtk_combo_box_set_active (GTK_COMBO_BOX (m_ui->ndevs_cbox), 0);
+    /* Same device still present - keep its session totals, just refresh the addresses */
+    if (m_ui->mon_dev[0] != '\0' && gtk_combo_box_set_active_id (GTK_COMBO_BOX (m_ui->ndevs_cbox), m_ui->mon_dev) == TRUE)
+    {
+	g_signal_handler_unblock (m_ui->ndevs_cbox, m_ui->dvcbx_hndlr_id);
+	show_dev_addr(m_ui);
+    }
+    else
+    {
+	m_ui->mon_dev[0] = '\0';
+	g_signal_handler_unblock (m_ui->ndevs_cbox, m_ui->dvcbx_hndlr_id);
+	gtk_combo_box_set_active (GTK_COMBO_BOX (m_ui->ndevs_cbox), 0);
+    }
+
+    if (running)
+	start_net_mon(m_ui);
 
     return;
 }
 
 
-/* Find network devices */
+/* Both lists have the same device names */
 
-GList * get_netdevices(MainUi *m_ui)
+int same_devs(GList *devs, GList *new_devs)
 {  
-    int r;
-    char errbuf[PCAP_ERRBUF_SIZE];
-    pcap_if_t *alldevs, *dev;
-    NetDevice *ndev;
     GList *l;
+    NetDevice *dev;
 
-    /* Ask pcap to find all devices for use */
-    r = pcap_findalldevs(&alldevs, errbuf);
+    if (g_list_length(devs) != g_list_length(new_devs))
+    	return FALSE;
 
-    /* Error checking */
-    if (r == -1)
+    for(l = new_devs; l != NULL; l = l->next)
     {
-	memset(app_msg_extra, '\0', sizeof(app_msg_extra));
-	strncpy(app_msg_extra, errbuf, sizeof(app_msg_extra));
-	log_msg("ERR0047", NULL, "ERR0047", m_ui->window);
-	return FALSE;
+    	dev = (NetDevice *) l->data;
+
+	if (find_dev(devs, dev->name) == NULL)
+	    return FALSE;
     }
 
-    if (alldevs == NULL)
+    return TRUE;
+}
+
+
+/* Find a device by name */
+
+NetDevice * find_dev(GList *devs, char *nm)
+{  
+    GList *l;
+    NetDevice *dev;
+
+    for(l = devs; l != NULL; l = l->next)
     {
-	sprintf(app_msg_extra, "No active, working dMAC_strevices found.");
-	log_msg("ERR0047", NULL, "ERR0047", m_ui->window);
-	return FALSE;
+    	dev = (NetDevice *) l->data;
+
+	if (strcmp(dev->name, nm) == 0)
+	    return dev;
     }
 
-    /* Save devices */
-    l = NULL;
+    return NULL;
+}
 
-    for(dev = alldevs; dev != NULL; dev = dev->next)
+
+/* Set up a row in the rates table and a stats entry for each device, plus a total row */
+
+void set_rate_table(MainUi *m_ui)
+{  
+    int i;
+    GList *l;
+    GtkWidget *lbl;
+    NetDevice *dev;
+    DevStats *ds;
+
+    /* Clear the table */
+    l = gtk_container_get_children(GTK_CONTAINER (m_ui->rate_grid));
+    g_list_free_full (l, (GDestroyNotify) gtk_widget_destroy);
+
+    create_label(&lbl, "title_4", "Device", m_ui->rate_grid, 0, 0, 1, 1);
+    create_label(&lbl, "title_4", "RX", m_ui->rate_grid, 1, 0, 1, 1);
+    create_label(&lbl, "title_4", "TX", m_ui->rate_grid, 2, 0, 1, 1);
+
+    /* The sampler must not be running while the stats are replaced */
+    stop_net_mon(m_ui);
+
+    /* Sample interval */
+    m_ui->mon_intvl = mon_pref(MON_INTVL, 1000, 100);
+
+    /* New stats array */
+    free_dev_stats(m_ui);
+
+    m_ui->dev_cnt = g_list_length(m_ui->ndevs);
+    m_ui->dev_stats = (DevStats *) calloc(m_ui->dev_cnt + 1, sizeof(DevStats));
+
+    for(l = m_ui->ndevs, i = 0; l != NULL; l = l->next, i++)
     {
-	/* Select valid devices */
-	if (dev->flags & PCAP_IF_LOOPBACK)
-	    continue;
+    	dev = (NetDevice *) l->data;
+    	ds = &(m_ui->dev_stats[i]);
+	init_dev_stats(ds, dev->name, m_ui);
+
+	create_label(&lbl, "data_1", dev->name, m_ui->rate_grid, 0, i + 1, 1, 1);
+	create_label(&(dev->rx_lbl), "data_1", "", m_ui->rate_grid, 1, i + 1, 1, 1);
+	create_label(&(dev->tx_lbl), "data_1", "", m_ui->rate_grid, 2, i + 1, 1, 1);
+    }
+
+    /* Aggregate */
+    create_label(&lbl, "title_4", "Total", m_ui->rate_grid, 0, i + 1, 1, 1);
+    create_label(&(m_ui->agg_rx), "data_1", "", m_ui->rate_grid, 1, i + 1, 1, 1);
+    create_label(&(m_ui->agg_tx), "data_1", "", m_ui->rate_grid, 2, i + 1, 1, 1);
+
+    gtk_widget_show_all(m_ui->rate_grid);
+
+    return;
+}
+
+
+/*
+** Devices have come or gone. Only their rows are removed or added (new ones at the end) and
+** the rates history of the devices still present is kept. The list and stats stay in row order.
+*/
+
+void update_rate_table(MainUi *m_ui, GList *new_devs)
+{  
+    int i, k;
+    GList *l, *devs;
+    GtkWidget *lbl;
+    NetDevice *dev, *ndev;
+    DevStats *ds;
+
+    /* The sampler must not be running while the stats are replaced */
+    stop_net_mon(m_ui);
 
-	if (!(dev->flags & PCAP_IF_RUNNING))
+    ds = (DevStats *) calloc(g_list_length(new_devs) + m_ui->dev_cnt + 1, sizeof(DevStats));
+    devs = NULL;
+    k = 0;
+
+    /* Existing devices - drop those gone, keep the rest as they are (current addresses) */
+    for(l = m_ui->ndevs, i = 0; l != NULL; l = l->next, i++)
+    {
+    	dev = (NetDevice *) l->data;
+
+	if ((ndev = find_dev(new_devs, dev->name)) == NULL)
+	{
+	    gtk_grid_remove_row (GTK_GRID (m_ui->rate_grid), k + 1);
+	    ring_free(&(m_ui->dev_stats[i].ring));
+	    rate_stats_free(&(m_ui->dev_stats[i].rx_st));
+	    rate_stats_free(&(m_ui->dev_stats[i].tx_st));
+	    free_dev(dev);
 	    continue;
+	}
+
+	strcpy(dev->ip, ndev->ip);
+	strcpy((char *) dev->mac, (char *) ndev->mac);
+	ds[k] = m_ui->dev_stats[i];
+	devs = g_list_append(devs, dev);
+	k++;
+    }
 
-	if (!(dev->flags & PCAP_IF_UP))
+    /* New devices */
+    for(l = new_devs; l != NULL; l = l->next)
+    {
+    	ndev = (NetDevice *) l->data;
+
+	if (find_dev(devs, ndev->name) != NULL)
 	    continue;
 
-	if (strcmp(dev->name, "any") == 0)
+	gtk_grid_insert_row (GTK_GRID (m_ui->rate_grid), k + 1);
+	init_dev_stats(&(ds[k]), ndev->name, m_ui);
+
+	create_label(&lbl, "data_1", ndev->name, m_ui->rate_grid, 0, k + 1, 1, 1);
+	create_label(&(ndev->rx_lbl), "data_1", "", m_ui->rate_grid, 1, k + 1, 1, 1);
+	create_label(&(ndev->tx_lbl), "data_1", "", m_ui->rate_grid, 2, k + 1, 1, 1);
+
+	devs = g_list_append(devs, ndev);
+	l->data = NULL;
+	k++;
+    }
+
+    /* Tidy up - entries left in the new list are duplicates of devices kept */
+    for(l = new_devs; l != NULL; l = l->next)
+    {
+	if (l->data != NULL)
+	    free_dev(l->data);
+    }
+
+    g_list_free(new_devs);
+    g_list_free(m_ui->ndevs);
+    free(m_ui->dev_stats);
+
+    m_ui->ndevs = devs;
+    m_ui->dev_stats = ds;
+    m_ui->dev_cnt = k;
+
+    gtk_widget_show_all(m_ui->rate_grid);
+
+    return;
+}
+
+
+/* Empty stats for a device, holding samples for the history period (also the percentile window) */
+
+void init_dev_stats(DevStats *ds, char *nm, MainUi *m_ui)
+{  
+    long n, hist;
+
+    hist = mon_pref(MON_HIST, 5, 1);
+    n = (hist * 60000) / m_ui->mon_intvl;
+
+    snprintf(ds->name, sizeof(ds->name), "%s", nm);
+    ring_init(&(ds->ring), n);
+    rate_stats_init(&(ds->rx_st), (double) hist * 60.0);
+    rate_stats_init(&(ds->tx_st), (double) hist * 60.0);
+
+    return;
+}
+
+
+/* Network devices from the interface cache (no rescan) */
+
+GList * get_netdevices(MainUi *m_ui)
+{  
+    int i, n;
+    IfEntry *ifs;
+    NetDevice *ndev;
+    GList *l;
+
+    n = netdev_list(&ifs);
+    l = NULL;
+
+    for(i = 0; i < n; i++)
+    {
+	/* Select valid devices */
+	if (netdev_active(&(ifs[i])) == FALSE)
 	    continue;
-	
+
 	ndev = new_dev();
 
 	/* Device name (eg. eth0) */
-	ndev->name = (char *) malloc(strlen(dev->name) + 1);
-	strcpy(ndev->name, dev->name);
+	ndev->name = (char *) malloc(strlen(ifs[i].name) + 1);
+	strcpy(ndev->name, ifs[i].name);
 
 	/* IP & MAC Address */
-	if (ip_address(dev->name, ndev->ip, ndev->mac) < 0)
-	{
-	    sprintf(app_msg_extra, "%s\n", strerror(errno));
-	    log_msg("ERR0047", NULL, "ERR0047", m_ui->window);
-	    return FALSE;
-	}
+	strcpy(ndev->ip, ifs[i].ip);
+	strcpy((char *) ndev->mac, (char *) ifs[i].mac);
 
 	/* Add to list */
 	l = g_list_prepend(l, ndev);
     }
 
     l = g_list_reverse(l);
-    pcap_freealldevs(alldevs);
 
     return l;
 }
@@ -383,6 +795,7 @@ GList * get_netdevices(MainUi *m_ui)
 NetDevice * new_dev()
 {  
     NetDevice *dev = (NetDevice *) malloc(sizeof(NetDevice));
+    memset(dev, 0, sizeof(NetDevice));
 
     return dev;
 }
@@ -402,21 +815,44 @@ void free_dev(void *l)
 }
 
 
-/* Display details for a selected device and initiate a thread to monitor performance */
+/* Show the addresses for the current device (they may change while it is selected) */
+
+void show_dev_addr(MainUi *m_ui)
+{
+    GList *l;
+    NetDevice *dev;
+
+    for(l = m_ui->ndevs; l != NULL; l = l->next)
+    {
+    	dev = (NetDevice *) l->data;
+
+	if (strcmp(dev->name, m_ui->mon_dev) == 0)
+	{
+	    gtk_label_set_text(GTK_LABEL (m_ui->ip_addr), dev->ip);
+	    gtk_label_set_text(GTK_LABEL (m_ui->mac_addr), dev->mac);
+	    break;
+	}
+    }
+
+    return;
+}
+
+
+/* Display details for a selected device. The sampler already covers all devices */
 
 int monitor_device(MainUi *m_ui)
 {
-    int p_err;
+    int r;
     char rx_s[31], tx_s[31];	// Possibly unsafe, but it would be a huge number
     gchar *txt;
     GList *l;
     NetDevice *dev;
 
     /* Selected device */
-    txt = gtk_combo_box_text_get_active_text (GTK_COMBO_BOX_TEXT (m_ui->ndevs_cbox));
+    if ((txt = gtk_combo_box_text_get_active_text (GTK_COMBO_BOX_TEXT (m_ui->ndevs_cbox))) == NULL)
+    	return FALSE;
 
-    /* Reset filenames */
-    reset_fn(m_ui);
+    r = TRUE;
 
     /* Match device details and display */
     for(l = m_ui->ndevs; l != NULL; l = l->next)
@@ -430,27 +866,21 @@ int monitor_device(MainUi *m_ui)
 	    gtk_label_set_text(GTK_LABEL (m_ui->mac_addr), dev->mac);
 
 	    /* Get new network totals */
-	    m_ui->rxfn = (char *) malloc(tx_rx_len + strlen(dev->name) + 1);
-	    sprintf(m_ui->rxfn, "%s%s%s", rtx_bytes_pfx, dev->name, rx_bytes_sfx);
-	    m_ui->txfn = (char *) malloc(tx_rx_len + strlen(dev->name) + 1);
-	    sprintf(m_ui->txfn, "%s%s%s", rtx_bytes_pfx, dev->name, tx_bytes_sfx);
-
-	    if (network_totals(m_ui->rxfn, rx_s, m_ui->txfn, tx_s, fsz) == FALSE)
-	    	return FALSE;
+	    if (network_totals(dev->name, rx_s, tx_s, fsz) == FALSE)
+	    {
+		log_msg("ERR0053", dev->name, NULL, NULL);
+	    	r = FALSE;
+	    	break;
+	    }
 
 	    /* Statistics */
 	    session_stats(rx_s, tx_s, &(m_ui->rx1), &(m_ui->tx1), m_ui);
+	    snprintf(m_ui->mon_dev, sizeof(m_ui->mon_dev), "%s", dev->name);
+	    gtk_widget_queue_draw (m_ui->spark_area);
 
-	    if (session_speed(m_ui) == FALSE)
-	    	break;
-
-	    /* Start performance monitor thread */
-	    if ((p_err = pthread_create(&(m_ui->net_speed_tid), NULL, &net_speed, (void *) m_ui)) != 0)
-	    {
-		sprintf(app_msg_extra, "Error: %s", strerror(p_err));
-		log_msg("ERR0048", NULL, "ERR0048", m_ui->window);
-		return FALSE;
-	    }
+	    /* Capture follows the selected device */
+	    if (capture_active() == TRUE && start_capture(dev->name, m_ui->window) == FALSE)
+		gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (m_ui->cap_chk), FALSE);
 
 	    break;
 	}
@@ -458,116 +888,442 @@ int monitor_device(MainUi *m_ui)
 
     g_free(txt);
 
+    return r;
+}
+
+
+/* Start the sampler thread if it is not already running */
+
+int start_net_mon(MainUi *m_ui)
+{
+    int p_err;
+
+    if (m_ui->net_speed_tid != 0)
+    {
+	if (m_ui->net_mon_stop == FALSE)
+	    return TRUE;
+
+	/* Previous sampler has finished (or is finishing) */
+	pthread_join(m_ui->net_speed_tid, NULL);
+	m_ui->net_speed_tid = 0;
+    }
+
+    m_ui->net_mon_stop = FALSE;
+
+    if ((p_err = pthread_create(&(m_ui->net_speed_tid), NULL, &net_speed, (void *) m_ui)) != 0)
+    {
+	m_ui->net_speed_tid = 0;
+	m_ui->net_mon_stop = TRUE;
+	sprintf(app_msg_extra, "Error: %s", strerror(p_err));
+	log_msg("ERR0048", NULL, "ERR0048", m_ui->window);
+	return FALSE;
+    }
+
     return TRUE;
 }
 
 
-/* Network speed performance thread */
+/* Stop the sampler thread and wait for it to finish */
+
+void stop_net_mon(MainUi *m_ui)
+{
+    if (m_ui->net_speed_tid == 0)
+    	return;
+
+    m_ui->net_mon_stop = TRUE;
+    pthread_join(m_ui->net_speed_tid, NULL);
+    m_ui->net_speed_tid = 0;
+
+    return;
+}
+
+
+/* Network speed sampler thread - all devices are sampled together */
 
 void * net_speed(void *arg)
 {  
-    double rx2, tx2;
-    char rx_s[31], tx_s[31];		// Possibly unsafe, but it would be a huge number
-    const gchar *nm;
     MainUi *m_ui;
-    const int interval = 1000000;	// microseconds (1.0 seconds)
-    //const int interval = 500000;	// microseconds (0.5 seconds)
+    struct timespec next;
 
     /* Initial */
     m_ui = (MainUi *) arg;
+    clock_gettime(CLOCK_MONOTONIC, &next);
 
-    /* Refresh and display current net speed */
-    while(1)
+    /* Refresh current net speeds */
+    while(m_ui->net_mon_stop == FALSE)
     {
-	/* Wait interval */
-	usleep(interval);
+	/* Wait until the next sample is due (absolute, so there is no drift) */
+	next.tv_nsec += (m_ui->mon_intvl % 1000) * 1000000;
+	next.tv_sec += m_ui->mon_intvl / 1000 + next.tv_nsec / 1000000000;
+	next.tv_nsec %= 1000000000;
+
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
 
 	/* Exit if 'monitor' is not the current panel */
-	nm = gtk_widget_get_name (m_ui->curr_panel);
+	if (m_ui->curr_panel != m_ui->mon_cntr)
+	    break;
+
+	/* Rates for each device, the main loop picks them up when it can */
+	sample_devices(mono_time(), m_ui);
+	post_net_rates(m_ui);
+    }
+
+    m_ui->net_mon_stop = TRUE;
+    pthread_exit(&net_mon);
+}
+
+
+/*
+** Read the counters for all links and set the rates for each monitored device.
+** The rates are written inside a sequence count (odd while writing) so the main loop can
+** take a consistent copy without a lock. The sample rings are published separately.
+*/
+
+void sample_devices(double ts, MainUi *m_ui)
+{
+    int i, j, n;
+    unsigned int seq;
+    double dt;
+    static LinkStats *ls = NULL;	// Sampler thread only
+    static int ls_max = 0;
+    DevStats *ds;
+    RateSample smpl;
+
+    if ((n = link_stats(&ls, &ls_max)) < 0)
+    	return;
+
+    seq = m_ui->stats_seq;
+    __atomic_store_n(&(m_ui->stats_seq), seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for(i = 0; i < m_ui->dev_cnt; i++)
+    {
+    	ds = &(m_ui->dev_stats[i]);
 
-	if (strcmp(nm, "monitor_panel") != 0)
+	for(j = 0; j < n; j++)
 	{
-	    reset_fn(m_ui);
-	    break;
+	    if (strcmp(ls[j].name, ds->name) == 0)
+	    	break;
 	}
 
-	/* If file name(s) is null, there may be new selection so just loop */
-	if (m_ui->rxfn == NULL || m_ui->txfn == NULL)
+	/* Device gone */
+	if (j >= n)
+	{
+	    ds->seen = FALSE;
+	    ds->rx_kbps = 0.0;
+	    ds->tx_kbps = 0.0;
 	    continue;
+	}
 
-	/* Get new network totals */
-	if (network_totals(m_ui->rxfn, rx_s, m_ui->txfn, tx_s, fsz) == FALSE)
-	    return FALSE;
+	/* Save the sample and work out the rate since the last one */
+	smpl.ts = ts;
+	smpl.rx_bytes = ls[j].rx_bytes;
+	smpl.tx_bytes = ls[j].tx_bytes;
+	ring_put(&(ds->ring), &smpl);
+
+	if (ring_rate(&(ds->ring), 0, &(ds->rx_kbps), &(ds->tx_kbps), &dt) == FALSE)
+	{
+	    ds->rx_kbps = 0.0;
+	    ds->tx_kbps = 0.0;
+	}
+	else
+	{
+	    rate_stats_add(&(ds->rx_st), ds->rx_kbps, dt, ts);
+	    rate_stats_add(&(ds->tx_st), ds->tx_kbps, dt, ts);
+	}
+
+	ds->seen = TRUE;
+    }
+
+    __atomic_store_n(&(m_ui->stats_seq), seq + 2, __ATOMIC_RELEASE);
+
+    return;
+}
+
+
+/* Ask the main loop for a display update unless one is already pending (sampler thread) */
+
+void post_net_rates(MainUi *m_ui)
+{
+    if (__atomic_exchange_n(&(m_ui->ui_pend), TRUE, __ATOMIC_ACQ_REL) == FALSE)
+	g_idle_add(show_net_rates, m_ui);
+
+    return;
+}
 
-	/* Statistics */
-	session_stats(rx_s, tx_s, &rx2, &tx2, m_ui);
 
-	/* Set progressbar */
-	display_speed(m_ui->rx_bar, m_ui->rx1, rx2, m_ui->sn_rx_kbps, &m_ui->max_kbps, m_ui->max_rxtx);
-	display_speed(m_ui->tx_bar, m_ui->tx1, tx2, m_ui->sn_tx_kbps, &m_ui->max_kbps, m_ui->max_rxtx);
+/* Consistent copy of the current rates and the statistics for device 'sel' if not -1 (main loop) */
 
-	/* Ready for next loop */
-	m_ui->rx1 = rx2;
-	m_ui->tx1 = tx2;
+int read_net_rates(MainUi *m_ui, double *rx_kbps, double *tx_kbps, int *seen, int sel, RateStats *rs)
+{
+    int i, tries;
+    unsigned int s1, s2;
+
+    for(tries = 0; tries < 100; tries++)
+    {
+	s1 = __atomic_load_n(&(m_ui->stats_seq), __ATOMIC_ACQUIRE);
+
+	if (s1 & 1)
+	    continue;
+
+	for(i = 0; i < m_ui->dev_cnt; i++)
+	{
+	    rx_kbps[i] = m_ui->dev_stats[i].rx_kbps;
+	    tx_kbps[i] = m_ui->dev_stats[i].tx_kbps;
+	    seen[i] = m_ui->dev_stats[i].seen;
+	}
+
+	if (sel >= 0)
+	{
+	    rs[0] = m_ui->dev_stats[sel].rx_st;
+	    rs[1] = m_ui->dev_stats[sel].tx_st;
+	}
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	s2 = __atomic_load_n(&(m_ui->stats_seq), __ATOMIC_RELAXED);
+
+	if (s1 == s2)
+	    return TRUE;
     }
-    
-    pthread_exit(&net_mon);
+
+    return FALSE;
+}
+
 
 /*
-printf("%s net_speed 8 rx_s: %s rx2 %0.2f   tx_s %s tx2 %0.2f\n", 
-    debug_hdr, rx_s, rx2, tx_s, tx2); fflush(stdout);
-printf("%s speed thread exit\n", debug_hdr); fflush(stdout);
+** Show the latest rates for all devices and the selected device (main loop).
+** Samples arriving in between are coalesced; the display is not updated more often than
+** every 'ui_min_ms' however fast the sampling.
 */
-}
 
+gboolean show_net_rates(gpointer user_data)
+{
+    int i, sel, *seen;
+    gint64 now, wait;
+    RateStats rs[2];
+    double rx_tot, tx_tot, tmp_bps;
+    double *rx_kbps, *tx_kbps;
+    char s[30], abbrev[5];
+    char rx_s[31], tx_s[31];
+    GList *l;
+    NetDevice *dev;
+    DevStats *ds;
+    RateSample smpl;
+    MainUi *m_ui;
 
-/* Reset filenames */
+    m_ui = (MainUi *) user_data;
 
-void reset_fn(MainUi *m_ui)
-{  
-    if (m_ui->rxfn != NULL)
+    /* Too soon since the last update, come back later (still pending) */
+    now = g_get_monotonic_time();
+    wait = (m_ui->ui_last + ui_min_ms * 1000 - now) / 1000;
+
+    if (wait > 0)
     {
-	free(m_ui->rxfn);
-	m_ui->rxfn = NULL;
+	g_timeout_add((guint) wait, show_net_rates, m_ui);
+	return FALSE;
     }
 
-    if (m_ui->txfn != NULL)
+    m_ui->ui_last = now;
+    __atomic_store_n(&(m_ui->ui_pend), FALSE, __ATOMIC_RELEASE);
+
+    /* Latest rates */
+    rx_kbps = (double *) malloc((m_ui->dev_cnt + 1) * sizeof(double));
+    tx_kbps = (double *) malloc((m_ui->dev_cnt + 1) * sizeof(double));
+    seen = (int *) malloc((m_ui->dev_cnt + 1) * sizeof(int));
+
+    for(sel = m_ui->dev_cnt - 1; sel >= 0; sel--)
     {
-	free(m_ui->txfn);
-	m_ui->txfn = NULL;
+	if (strcmp(m_ui->dev_stats[sel].name, m_ui->mon_dev) == 0)
+	    break;
+    }
+
+    if (read_net_rates(m_ui, rx_kbps, tx_kbps, seen, sel, rs) == FALSE)
+    {
+	free(rx_kbps);
+	free(tx_kbps);
+	free(seen);
+	return FALSE;
+    }
+
+    rx_tot = 0.0;
+    tx_tot = 0.0;
+
+    for(l = m_ui->ndevs, i = 0; l != NULL && i < m_ui->dev_cnt; l = l->next, i++)
+    {
+    	dev = (NetDevice *) l->data;
+    	ds = &(m_ui->dev_stats[i]);
+
+	if (seen[i] == FALSE)
+	{
+	    gtk_label_set_text(GTK_LABEL (dev->rx_lbl), "-");
+	    gtk_label_set_text(GTK_LABEL (dev->tx_lbl), "-");
+	    continue;
+	}
+
+	bps_abbrev(rx_kbps[i], &tmp_bps, abbrev);
+	sprintf(s, "%0.2f %s", tmp_bps, abbrev);
+	gtk_label_set_text(GTK_LABEL (dev->rx_lbl), s);
+
+	bps_abbrev(tx_kbps[i], &tmp_bps, abbrev);
+	sprintf(s, "%0.2f %s", tmp_bps, abbrev);
+	gtk_label_set_text(GTK_LABEL (dev->tx_lbl), s);
+
+	rx_tot += rx_kbps[i];
+	tx_tot += tx_kbps[i];
+
+	/* Selected device */
+	if (strcmp(ds->name, m_ui->mon_dev) == 0 && ring_last(&(ds->ring), &smpl) == TRUE)
+	{
+	    snprintf(rx_s, sizeof(rx_s), "%llu", smpl.rx_bytes);
+	    snprintf(tx_s, sizeof(tx_s), "%llu", smpl.tx_bytes);
+	    session_stats(rx_s, tx_s, &(m_ui->rx1), &(m_ui->tx1), m_ui);
+	    today_stats(ds->name, &smpl, m_ui);
+	    gtk_widget_queue_draw (m_ui->spark_area);
+	    show_rate_stats(m_ui, rs, rx_kbps[i], tx_kbps[i]);
+	}
+    }
+
+    free(rx_kbps);
+    free(tx_kbps);
+    free(seen);
+
+    if (capture_active() == TRUE)
+	show_talkers(m_ui);
+
+    /* Aggregate */
+    bps_abbrev(rx_tot, &tmp_bps, abbrev);
+    sprintf(s, "%0.2f %s", tmp_bps, abbrev);
+    gtk_label_set_text(GTK_LABEL (m_ui->agg_rx), s);
+
+    bps_abbrev(tx_tot, &tmp_bps, abbrev);
+    sprintf(s, "%0.2f %s", tmp_bps, abbrev);
+    gtk_label_set_text(GTK_LABEL (m_ui->agg_tx), s);
+
+    return FALSE;
+}
+
+
+/* Speed statistics for the selected device */
+
+void show_rate_stats(MainUi *m_ui, RateStats *rs, double rx_now, double tx_now)
+{
+    int i, j;
+    double v[RS_COLS], tmp_bps;
+    char s[30], abbrev[5];
+    GtkWidget **lbl;
+
+    for(i = 0; i < 2; i++)
+    {
+	v[0] = (i == 0) ? rx_now : tx_now;
+	v[1] = rs[i].ewma_s;
+	v[2] = rs[i].ewma_l;
+	v[3] = rs[i].p50;
+	v[4] = rs[i].p95;
+	v[5] = rs[i].p99;
+	v[6] = rs[i].peak;
+	lbl = (i == 0) ? m_ui->rx_spd : m_ui->tx_spd;
+
+	for(j = 0; j < RS_COLS; j++)
+	{
+	    bps_abbrev(v[j], &tmp_bps, abbrev);
+	    sprintf(s, "%0.2f %s", tmp_bps, abbrev);
+	    gtk_label_set_text(GTK_LABEL (lbl[j]), s);
+	}
     }
 
     return;
 }
 
 
-/* Read the network device current totals */
+/* Read the network device current totals (all links are queried at once) */
 
-int network_totals(char *rxfn, char *rx, char *txfn, char *tx, const int fsz)
+int network_totals(char *nm, char *rx, char *tx, const int fsz)
 {
-    int r;
-    char *p;
-    FILE *fd;
+    int i, n;
+    static LinkStats *ls = NULL;	// Main loop only
+    static int ls_max = 0;
 
-    /* RX */
-    fd = open_file(rxfn, "r");
-    
-    if ((r = read_file(fd, rx, (int) fsz)) != EOF)
+    if ((n = link_stats(&ls, &ls_max)) < 0)
 	return FALSE;
 
-    if ((p = strchr(rx, '\n')) != NULL)
-	*p = '\0';
+    for(i = 0; i < n; i++)
+    {
+	if (strcmp(ls[i].name, nm) == 0)
+	{
+	    snprintf(rx, fsz, "%llu", ls[i].rx_bytes);
+	    snprintf(tx, fsz, "%llu", ls[i].tx_bytes);
+	    return TRUE;
+	}
+    }
 
-    /* TX */
-    fd = open_file(txfn, "r");
-    
-    if ((r = read_file(fd, tx, (int) fsz)) != EOF)
-	return FALSE;
+    return FALSE;
+}
 
-    if ((p = strchr(tx, '\n')) != NULL)
-	*p = '\0';
 
-    return TRUE;
+/* Today's totals for a device from the traffic ledger (current counters given) */
+
+void today_stats(char *nm, RateSample *smpl, MainUi *m_ui)
+{
+    unsigned long long rx, tx;
+    char rx_s[31], tx_s[31];
+
+    if (ledger_today(nm, smpl->rx_bytes, smpl->tx_bytes, &rx, &tx) == FALSE)
+    	return;
+
+    snprintf(rx_s, sizeof(rx_s), "%llu", rx);
+    snprintf(tx_s, sizeof(tx_s), "%llu", tx);
+    set_sz_abbrev(rx_s);
+    set_sz_abbrev(tx_s);
+    gtk_label_set_text(GTK_LABEL (m_ui->rx_today), rx_s);
+    gtk_label_set_text(GTK_LABEL (m_ui->tx_today), tx_s);
+
+    return;
+}
+
+
+/* Remote hosts and ports with the most traffic in the capture */
+
+void show_talkers(MainUi *m_ui)
+{
+    int i, n;
+    char s[INET6_ADDRSTRLEN];
+    FlowEntry top[TOP_TALKERS];
+
+    n = capture_top(top, TOP_TALKERS);
+
+    for(i = 0; i < TOP_TALKERS; i++)
+    {
+	if (i >= n)
+	{
+	    gtk_label_set_text(GTK_LABEL (m_ui->talk_host[i]), "");
+	    gtk_label_set_text(GTK_LABEL (m_ui->talk_port[i]), "");
+	    gtk_label_set_text(GTK_LABEL (m_ui->talk_rx[i]), "");
+	    gtk_label_set_text(GTK_LABEL (m_ui->talk_tx[i]), "");
+	    continue;
+	}
+
+	inet_ntop((top[i].key.family == 4) ? AF_INET : AF_INET6, top[i].key.addr, s, sizeof(s));
+	gtk_label_set_text(GTK_LABEL (m_ui->talk_host[i]), s);
+
+	if (top[i].key.proto == 6)
+	    sprintf(s, "%u/tcp", top[i].key.port);
+	else if (top[i].key.proto == 17)
+	    sprintf(s, "%u/udp", top[i].key.port);
+	else
+	    sprintf(s, "proto %u", top[i].key.proto);
+
+	gtk_label_set_text(GTK_LABEL (m_ui->talk_port[i]), s);
+
+	snprintf(s, sizeof(s), "%llu", top[i].rx_bytes);
+	set_sz_abbrev(s);
+	gtk_label_set_text(GTK_LABEL (m_ui->talk_rx[i]), s);
+
+	snprintf(s, sizeof(s), "%llu", top[i].tx_bytes);
+	set_sz_abbrev(s);
+	gtk_label_set_text(GTK_LABEL (m_ui->talk_tx[i]), s);
+    }
+
+    return;
 }
 
 
@@ -586,89 +1342,265 @@ void session_stats(char *rx_s, char *tx_s, double *rx, double *tx, MainUi *m_ui)
 }
 
 
-// Set the Progress bars to indicate speeds.
-// This is only an approximate speed indicator and not a performance monitor.
-// It is really a fudge using ProgressBars to display a meter by continually
-// changing the value.
-// Doing this requires a notional 100 percent complete speed never to attained.
-// The formula for this is entirely arbitrary:-
-//   . Work out the average speed for the session (total bytes / uptime secs).
-//   . Set this as the 75% mark, thus 1.5x is the maximum.
-//   . From then on, at each iteration, if the current speed >= the maximum,
-//     reset the maximum to current speed plus 25% - This will almost certainly
-//     happen as the session figure will be skewed low, but it should stabalise
-//   (NB 75% and 25% area set constants that may change - see code).
-// All speeds are worked out based on Kb/s (kilobits/sec), but should be displayed as Kb/s, Mb/s
-// and Gb/s as appropriate.
+/*
+** Draw a scrolling sparkline of the RX and TX rates for the selected device from its sample ring.
+** The most recent sample is at the right hand side, one pixel per sample, scaled to the peak shown.
+*/
 
-void display_speed(GtkWidget *pbar, double x1, double x2, double sn_kbps, double *max_kbps, GtkWidget *max_bps)
+void draw_sparkline(cairo_t *cr, GtkAllocation *alloc, MainUi *m_ui)
 {
-    int max_lbl;
-    double x_kbps, tmp_bps;
-    char s[30], abbrev[5];
-    const double max_kbps_init = 1.5;
-    const double max_kbps_adj = 1.25;
+    unsigned long i, n;
+    double rx, tx, peak, x, h;
+    double *rx_v, *tx_v;
+    DevStats *ds;
+
+    /* Background */
+    cairo_set_source_rgb (cr, WHITE.red, WHITE.green, WHITE.blue);
+    cairo_rectangle (cr, 0, 0, alloc->width, alloc->height);
+    cairo_fill (cr);
+
+    if ((ds = selected_dev(m_ui)) == NULL || (n = ring_count(&(ds->ring))) < 2)
+    	return;
+
+    /* Rates for the samples that fit the width */
+    n--;
+
+    if (n > (unsigned long) alloc->width)
+    	n = (unsigned long) alloc->width;
+
+    rx_v = (double *) malloc(n * sizeof(double));
+    tx_v = (double *) malloc(n * sizeof(double));
+    peak = 0.0;
+
+    for(i = 0; i < n; i++)
+    {
+	if (ring_rate(&(ds->ring), i, &rx, &tx, NULL) == FALSE)
+	    break;
+
+	rx_v[i] = rx;
+	tx_v[i] = tx;
+
+	if (rx > peak)
+	    peak = rx;
+
+	if (tx > peak)
+	    peak = tx;
+    }
 
-    /* Calculate current speed */
-    x_kbps = (x2 - x1) / kbps_dv;
+    n = i;
+    h = (double) alloc->height - 2.0;
 
-    /* Set maximun if required */
-    max_lbl = FALSE;
+    if (peak <= 0.0)
+    	peak = 1.0;
 
-    if (*max_kbps == 0.0)
+    /* RX */
+    cairo_set_line_width (cr, 1.0);
+    cairo_set_source_rgb (cr, DARK_BLUE.red, DARK_BLUE.green, DARK_BLUE.blue);
+
+    for(i = 0; i < n; i++)
     {
-	*max_kbps = sn_kbps * max_kbps_init;
-	max_lbl = TRUE;
+	x = (double) alloc->width - (double) i - 0.5;
+
+	if (i == 0)
+	    cairo_move_to (cr, x, 1.0 + h - (rx_v[i] / peak) * h);
+	else
+	    cairo_line_to (cr, x, 1.0 + h - (rx_v[i] / peak) * h);
     }
-    else if (x_kbps >= *max_kbps)
+
+    cairo_stroke (cr);
+
+    /* TX */
+    cairo_set_source_rgb (cr, DARK_MAROON.red, DARK_MAROON.green, DARK_MAROON.blue);
+
+    for(i = 0; i < n; i++)
     {
-    	*max_kbps = x_kbps * max_kbps_adj;
-	max_lbl = TRUE;
+	x = (double) alloc->width - (double) i - 0.5;
+
+	if (i == 0)
+	    cairo_move_to (cr, x, 1.0 + h - (tx_v[i] / peak) * h);
+	else
+	    cairo_line_to (cr, x, 1.0 + h - (tx_v[i] / peak) * h);
     }
 
-    bps_abbrev(x_kbps, &tmp_bps, abbrev);
-    sprintf(s, "%0.2f %s", tmp_bps, abbrev);
-    gtk_progress_bar_set_text (GTK_PROGRESS_BAR (pbar), s);
-    gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (pbar), x_kbps / *max_kbps);
+    cairo_stroke (cr);
+
+    free(rx_v);
+    free(tx_v);
+
+    return;
+}
+
 
-    if (max_lbl == TRUE)
+/* Stats for the device selected for display (main loop only) */
+
+DevStats * selected_dev(MainUi *m_ui)
+{
+    int i;
+
+    for(i = 0; i < m_ui->dev_cnt; i++)
     {
-	bps_abbrev(*max_kbps, &tmp_bps, abbrev);
-	sprintf(s, "(Max.: %0.2f %s)", tmp_bps, abbrev);
-	gtk_label_set_text(GTK_LABEL (max_bps), s);
+	if (strcmp(m_ui->dev_stats[i].name, m_ui->mon_dev) == 0)
+	    return &(m_ui->dev_stats[i]);
     }
 
+    return NULL;
+}
+
+
+/* Set up a sample ring to hold at least n samples */
+
+void ring_init(SampleRing *ring, unsigned long n)
+{
+    ring->sz = 2;
+
+    while(ring->sz < n)
+    	ring->sz <<= 1;
+
+    ring->smpl = (RateSample *) calloc(ring->sz, sizeof(RateSample));
+    ring->head = 0;
+
     return;
-/*
-printf("%s display_speed 1 x1:  %0.2f   x2  %0.2f\n", debug_hdr, x1, x2); fflush(stdout);
-printf("%s display_speed 1a x_kbps:  %0.2f   max_kbps  %0.2f\n", debug_hdr, x_kbps, *max_kbps); fflush(stdout);
-printf("%s display_speed 3 max_kbps:  %0.2f\n", debug_hdr, *max_kbps); fflush(stdout);
-printf("%s display_speed 4 max_kbps:  %0.2f\n", debug_hdr, *max_kbps); fflush(stdout);
-printf("%s display_speed 1 s: %s\n", debug_hdr, s); fflush(stdout);
-*/
 }
 
 
-/* Determine the session speed averages */
+/* Free the rings and statistics for all devices */
 
-int session_speed(MainUi *m_ui)
+void free_dev_stats(MainUi *m_ui)
 {
-    struct sysinfo info;
+    int i;
 
-    if (sysinfo(&info) != 0)
+    for(i = 0; i < m_ui->dev_cnt; i++)
     {
-	check_errno;
-	return FALSE;
+    	ring_free(&(m_ui->dev_stats[i].ring));
+    	rate_stats_free(&(m_ui->dev_stats[i].rx_st));
+    	rate_stats_free(&(m_ui->dev_stats[i].tx_st));
     }
 
-    m_ui->sn_rx_kbps = (m_ui->rx1 / (double) info.uptime) / kbps_dv;
-    m_ui->sn_tx_kbps = (m_ui->tx1 / (double) info.uptime) / kbps_dv;
+    free(m_ui->dev_stats);
+    m_ui->dev_stats = NULL;
+    m_ui->dev_cnt = 0;
+
+    return;
+}
+
+
+/* Free a sample ring */
+
+void ring_free(SampleRing *ring)
+{
+    free(ring->smpl);
+    ring->smpl = NULL;
+    ring->sz = 0;
+    ring->head = 0;
+
+    return;
+}
+
+
+/* Add a sample (sampler thread only). The sample is stored before the head is published */
+
+void ring_put(SampleRing *ring, RateSample *smpl)
+{
+    unsigned long h;
+
+    h = ring->head;
+    ring->smpl[h & (ring->sz - 1)] = *smpl;
+    __atomic_store_n(&(ring->head), h + 1, __ATOMIC_RELEASE);
+
+    return;
+}
+
+
+/* Number of samples available, leaving a margin for the slot being written */
+
+unsigned long ring_count(SampleRing *ring)
+{
+    unsigned long h;
+
+    h = __atomic_load_n(&(ring->head), __ATOMIC_ACQUIRE);
+
+    return (h < ring->sz - 1) ? h : ring->sz - 1;
+}
+
 
-    return TRUE;
 /*
-printf("%s session_speed 1 rx %0.2f  tx %0.2f\n", 
-    debug_hdr, m_ui->sn_rx_kbps, m_ui->sn_tx_kbps); fflush(stdout);
+** Rates (Kb/s) between a sample and the one before it, 'back' samples from the latest,
+** and optionally the interval. A counter that goes backwards (reset, wrap) gives no rate.
 */
+
+int ring_rate(SampleRing *ring, unsigned long back, double *rx_kbps, double *tx_kbps, double *dt_ret)
+{
+    unsigned long h, m;
+    double dt;
+    RateSample *s1, *s2;
+
+    h = __atomic_load_n(&(ring->head), __ATOMIC_ACQUIRE);
+    m = ring->sz - 1;
+
+    if (back + 2 > ring_count(ring))
+    	return FALSE;
+
+    s2 = &(ring->smpl[(h - 1 - back) & m]);
+    s1 = &(ring->smpl[(h - 2 - back) & m]);
+
+    if ((dt = s2->ts - s1->ts) <= 0.0)
+    	return FALSE;
+
+    *rx_kbps = (s2->rx_bytes >= s1->rx_bytes) ? (double) (s2->rx_bytes - s1->rx_bytes) / dt / kbps_dv : 0.0;
+    *tx_kbps = (s2->tx_bytes >= s1->tx_bytes) ? (double) (s2->tx_bytes - s1->tx_bytes) / dt / kbps_dv : 0.0;
+
+    if (dt_ret != NULL)
+    	*dt_ret = dt;
+
+    return TRUE;
+}
+
+
+/* Most recent sample */
+
+int ring_last(SampleRing *ring, RateSample *smpl)
+{
+    unsigned long h;
+
+    h = __atomic_load_n(&(ring->head), __ATOMIC_ACQUIRE);
+
+    if (h == 0)
+    	return FALSE;
+
+    *smpl = ring->smpl[(h - 1) & (ring->sz - 1)];
+
+    return TRUE;
+}
+
+
+/* Monotonic clock time in seconds */
+
+double mono_time()
+{
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+
+    return (double) tp.tv_sec + (double) tp.tv_nsec / 1000000000.0;
+}
+
+
+/* Numeric monitor preference with a default and a minimum */
+
+long mon_pref(char *key, long dflt, long min)
+{
+    long v;
+    char *p;
+
+    get_user_pref(key, &p);
+
+    if (p == NULL || (v = atol(p)) <= 0)
+    	v = dflt;
+
+    if (v < min)
+    	v = min;
+
+    return v;
 }
 
 
@@ -0,0 +1,201 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	Network interface statistics include file
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial
+**	19-Oct-2026	Rate statistics (EWMA, peak, percentiles)
+**	19-Oct-2026	Traffic ledger
+**	19-Oct-2026	Flow table (per remote host and port) for packet capture
+**	19-Oct-2026	Interface cache kept current from netlink events
+**
+*/
+
+
+/* Defines */
+
+#ifndef NET_STATS_HDR
+#define NET_STATS_HDR
+
+#define LINK_NAME_SZ 16
+#define RS_SUB 16			// Histogram sub-buckets per power of 2 (about 6% resolution)
+#define RS_MAG 41			// Powers of 2 covered (bytes per second)
+#define RS_BKT (RS_SUB * 2 + (RS_MAG - 5) * RS_SUB)
+#define RS_SLOTS 4			// Sliding window is made up of this many slots
+#define RS_TAU_S 10.0			// Short EWMA time constant (seconds)
+#define RS_TAU_L 60.0			// Long EWMA time constant (seconds)
+#define RS_COLS 7			// Statistics shown (now, averages, percentiles, peak)
+
+
+/* Counters for a link (interface) */
+
+typedef struct _link_stats
+{
+    char name[LINK_NAME_SZ];
+    int ifindex;
+    int wrap32;				// 32 bit counters (IFLA_STATS) that may wrap
+    unsigned long long rx_bytes;
+    unsigned long long tx_bytes;
+} LinkStats;
+
+
+/* Interface details (cached, updated from netlink events) */
+
+typedef struct _if_entry
+{
+    char name[LINK_NAME_SZ];
+    int ifindex;
+    unsigned int flags;			// IFF_*
+    char ip[16];			// IPv4 address text
+    unsigned char mac[18];
+} IfEntry;
+
+
+/* Counter sample stamped with the monotonic clock (seconds) */
+
+typedef struct _rate_sample
+{
+    double ts;
+    unsigned long long rx_bytes;
+    unsigned long long tx_bytes;
+} RateSample;
+
+
+/*
+** Fixed size ring of recent samples. Only the sampler thread writes (advancing head
+** after the sample is stored) and the main loop reads, so no lock is required.
+*/
+
+typedef struct _sample_ring
+{
+    RateSample *smpl;
+    unsigned long sz;			// Power of 2
+    unsigned long head;			// Total samples written
+} SampleRing;
+
+
+/*
+** Log bucketed histogram of rates over a sliding window. The window is split into slots
+** and the oldest slot is cleared as time moves on, so memory is constant.
+*/
+
+typedef struct _rate_hist
+{
+    unsigned int cnt[RS_SLOTS][RS_BKT];
+    unsigned long total[RS_SLOTS];
+    double slot_len;
+    double slot_start;
+    int slot;
+} RateHist;
+
+
+/* Streaming statistics for one direction of a device (Kb/s) */
+
+typedef struct _rate_stats
+{
+    double ewma_s, ewma_l;
+    double peak;
+    double p50, p95, p99;
+    int primed;
+    RateHist *hist;
+} RateStats;
+
+
+/* Rates for a monitored device (updated by the sampler thread) */
+
+typedef struct _dev_stats
+{
+    char name[LINK_NAME_SZ];
+    double rx_kbps, tx_kbps;
+    int seen;
+    RateStats rx_st, tx_st;
+    SampleRing ring;
+} DevStats;
+
+
+
+/* Traffic ledger record - bytes for a device in an hour (hours since the epoch, UTC) */
+
+#define LDG_MAGIC 0x4c444731		// "LDG1"
+
+typedef struct _ledger_rec
+{
+    unsigned int magic;
+    unsigned int hour;
+    char name[LINK_NAME_SZ];
+    unsigned long long rx_bytes;
+    unsigned long long tx_bytes;
+} LedgerRec;
+
+
+/* Ledger state for a device: last counters seen, bytes not yet written and today's total */
+
+typedef struct _ledger_dev
+{
+    char name[LINK_NAME_SZ];
+    int ifindex;
+    int seen;
+    int wrap32;				// Counters last seen were 32 bit
+    unsigned long long rx_last, tx_last;
+    unsigned long long rx_pend, tx_pend;
+    unsigned long long rx_day, tx_day;
+} LedgerDev;
+
+
+/* Flow table - bytes per remote host and port, open addressing with linear probing */
+
+#define FLOW_MAX 65536			// Capacity limit, further flows are counted as 'other'
+#define CAP_SNAPLEN 128			// Enough for link, IP and TCP/UDP port headers
+#define TOP_TALKERS 8
+
+typedef struct _flow_key
+{
+    unsigned char addr[16];		// IPv4 uses the first 4 bytes
+    unsigned short port;
+    unsigned char proto;
+    unsigned char family;		// 4, 6 or 0 (other / table full)
+} FlowKey;
+
+typedef struct _flow_entry
+{
+    FlowKey key;
+    int used;
+    unsigned long long rx_bytes, tx_bytes;
+    unsigned long long pkts;
+} FlowEntry;
+
+typedef struct _flow_table
+{
+    FlowEntry *ent;
+    unsigned int sz;			// Power of 2
+    unsigned int cnt;
+    FlowEntry other;
+    FlowKey *local;			// Local addresses (decide direction)
+    int local_cnt;
+    unsigned long long pkts, bytes;
+} FlowTable;
+
+#endif
@@ -0,0 +1,533 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:
+**  Network interface list kept current without rescanning.
+**  One getifaddrs() call seeds the list, then a netlink socket subscribed to link and
+**  address changes (RTMGRP_LINK, RTMGRP_IPV4_IFADDR, RTMGRP_IPV6_IFADDR) is watched from
+**  the main loop and the list updated as interfaces come and go (VPN, tethering etc.).
+**  The getifaddrs() call is made on a short lived thread so it does not hold up startup.
+**  The result is applied on the main loop and only then are the events watched (they
+**  queue on the socket meanwhile), so the list is only ever changed on the main loop.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	Seed in the background
+**
+*/
+
+
+/* Defines */
+
+#define NL_EVT_BUF 16384
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_packet.h>
+#include <gtk/gtk.h>
+#include <glib-unix.h>
+#include <net_stats.h>
+#include <defs.h>
+
+
+/* Types */
+
+typedef struct _seed_job
+{
+    struct ifaddrs *ifa_list;
+    int err;
+} SeedJob;
+
+
+/* Prototypes */
+
+int netdev_init(void (*)(gpointer), gpointer);
+void netdev_close();
+int netdev_list(IfEntry **);
+int netdev_active(IfEntry *);
+int netdev_ready();
+gboolean netdev_event(gint, GIOCondition, gpointer);
+int netdev_seed();
+void * seed_thread(void *);
+gboolean seed_done(gpointer);
+void seed_list(struct ifaddrs *);
+void link_msg(struct nlmsghdr *);
+void addr_msg(struct nlmsghdr *);
+IfEntry * if_find(int, char *, int);
+void if_remove(int);
+void set_mac(IfEntry *, unsigned char *, int);
+
+extern void log_msg(char*, char*, char*, GtkWidget*);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-netdev.c ";
+static IfEntry *ifs = NULL;
+static int if_cnt = 0;
+static int if_max = 0;
+static int ev_sock = -1;
+static guint ev_src = 0;
+static void (*changed_fn)(gpointer) = NULL;
+static gpointer changed_data = NULL;
+static int seeded = FALSE;
+
+
+
+/* Subscribe to changes then seed the list. 'fn' is called (main loop) when the list changes */
+
+int netdev_init(void (*fn)(gpointer), gpointer data)
+{
+    int p_err;
+    pthread_t seed_tid;
+    struct sockaddr_nl sa;
+
+    changed_fn = fn;
+    changed_data = data;
+
+    /* Subscribe first so nothing is missed between the seed and the first event */
+    if ((ev_sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE)) >= 0)
+    {
+	memset(&sa, 0, sizeof(sa));
+	sa.nl_family = AF_NETLINK;
+	sa.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+
+	if (bind(ev_sock, (struct sockaddr *) &sa, sizeof(sa)) < 0)
+	{
+	    close(ev_sock);
+	    ev_sock = -1;
+	}
+    }
+
+    if (ev_sock < 0)
+    {
+	sprintf(app_msg_extra, "%s", strerror(errno));
+	log_msg("ERR0047", NULL, "ERR0047", NULL);
+    }
+
+    /* Seed in the background (or here if a thread is not available) */
+    if ((p_err = pthread_create(&seed_tid, NULL, &seed_thread, NULL)) != 0)
+    {
+	netdev_seed();
+	seed_done(NULL);
+	return TRUE;
+    }
+
+    pthread_detach(seed_tid);
+
+    return TRUE;
+}
+
+
+/* Stop watching and free */
+
+void netdev_close()
+{
+    if (ev_src != 0)
+    {
+	g_source_remove(ev_src);
+	ev_src = 0;
+    }
+
+    if (ev_sock >= 0)
+    {
+	close(ev_sock);
+	ev_sock = -1;
+    }
+
+    free(ifs);
+    ifs = NULL;
+    if_cnt = 0;
+    if_max = 0;
+    changed_fn = NULL;
+    seeded = FALSE;
+
+    return;
+}
+
+
+/* Current list (main loop only, valid until the next change) */
+
+int netdev_list(IfEntry **list)
+{
+    *list = ifs;
+
+    return if_cnt;
+}
+
+
+/* Device can be monitored - up, running and not loopback */
+
+int netdev_active(IfEntry *ife)
+{
+    if (ife->flags & IFF_LOOPBACK)
+    	return FALSE;
+
+    if (! (ife->flags & IFF_UP) || ! (ife->flags & IFF_RUNNING))
+    	return FALSE;
+
+    return TRUE;
+}
+
+
+/* The initial list is in place */
+
+int netdev_ready()
+{
+    return seeded;
+}
+
+
+/* Netlink events - read everything waiting then report one change */
+
+gboolean netdev_event(gint fd, GIOCondition cond, gpointer user_data)
+{
+    int len, changed;
+    char buf[NL_EVT_BUF];
+    struct nlmsghdr *nh;
+
+    changed = FALSE;
+
+    while((len = recv(fd, buf, sizeof(buf), 0)) > 0)
+    {
+	for(nh = (struct nlmsghdr *) buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len))
+	{
+	    switch(nh->nlmsg_type)
+	    {
+		case RTM_NEWLINK:
+		case RTM_DELLINK:
+		    link_msg(nh);
+		    changed = TRUE;
+		    break;
+
+		case RTM_NEWADDR:
+		case RTM_DELADDR:
+		    addr_msg(nh);
+		    changed = TRUE;
+		    break;
+
+		default:
+		    break;
+	    }
+	}
+    }
+
+    /* Events lost (socket buffer overrun), start again from the current state */
+    if (len < 0 && errno == ENOBUFS)
+    {
+	if_cnt = 0;
+	netdev_seed();
+	changed = TRUE;
+    }
+
+    if (changed == TRUE && changed_fn != NULL)
+	(*changed_fn)(changed_data);
+
+    return G_SOURCE_CONTINUE;
+}
+
+
+/* Initial list from getifaddrs, here and now (main loop) */
+
+int netdev_seed()
+{
+    struct ifaddrs *ifa_list;
+
+    if (getifaddrs(&ifa_list) < 0)
+    {
+	sprintf(app_msg_extra, "%s", strerror(errno));
+	log_msg("ERR0047", NULL, "ERR0047", NULL);
+	return FALSE;
+    }
+
+    seed_list(ifa_list);
+    freeifaddrs(ifa_list);
+
+    return TRUE;
+}
+
+
+/* Seed thread - the getifaddrs call only, the result is passed to the main loop */
+
+void * seed_thread(void *arg)
+{
+    SeedJob *job;
+
+    job = (SeedJob *) malloc(sizeof(SeedJob));
+    job->err = 0;
+
+    if (getifaddrs(&(job->ifa_list)) < 0)
+    {
+	job->ifa_list = NULL;
+	job->err = errno;
+    }
+
+    g_idle_add(seed_done, job);
+
+    return NULL;
+}
+
+
+/* Seed complete (main loop) - load the list, start watching for changes and report it */
+
+gboolean seed_done(gpointer user_data)
+{
+    SeedJob *job;
+
+    job = (SeedJob *) user_data;
+
+    if (job != NULL)
+    {
+	if (job->ifa_list == NULL)
+	{
+	    sprintf(app_msg_extra, "%s", strerror(job->err));
+	    log_msg("ERR0047", NULL, "ERR0047", NULL);
+	}
+	else
+	{
+	    seed_list(job->ifa_list);
+	    freeifaddrs(job->ifa_list);
+	}
+
+	free(job);
+    }
+
+    seeded = TRUE;
+
+    if (ev_sock >= 0)
+	ev_src = g_unix_fd_add(ev_sock, G_IO_IN, netdev_event, NULL);
+
+    if (changed_fn != NULL)
+	(*changed_fn)(changed_data);
+
+    return G_SOURCE_REMOVE;
+}
+
+
+/* Add the getifaddrs entries to the list (one entry per address, grouped here by name) */
+
+void seed_list(struct ifaddrs *ifa_list)
+{
+    struct ifaddrs *ifa;
+    struct sockaddr_ll *sll;
+    IfEntry *ife;
+
+    for(ifa = ifa_list; ifa != NULL; ifa = ifa->ifa_next)
+    {
+	ife = if_find(if_nametoindex(ifa->ifa_name), ifa->ifa_name, TRUE);
+	ife->flags = ifa->ifa_flags;
+
+	if (ifa->ifa_addr == NULL)
+	    continue;
+
+	if (ifa->ifa_addr->sa_family == AF_INET && ife->ip[0] == '\0')
+	{
+	    inet_ntop(AF_INET, &(((struct sockaddr_in *) ifa->ifa_addr)->sin_addr), ife->ip, sizeof(ife->ip));
+	}
+	else if (ifa->ifa_addr->sa_family == AF_PACKET)
+	{
+	    sll = (struct sockaddr_ll *) ifa->ifa_addr;
+	    set_mac(ife, sll->sll_addr, sll->sll_halen);
+	}
+    }
+
+    return;
+}
+
+
+/* Link added, changed or removed */
+
+void link_msg(struct nlmsghdr *nh)
+{
+    int len;
+    char name[LINK_NAME_SZ];
+    struct ifinfomsg *ifi;
+    struct rtattr *rta;
+    unsigned char *mac;
+    int mac_len;
+    IfEntry *ife;
+
+    ifi = (struct ifinfomsg *) NLMSG_DATA(nh);
+
+    if (nh->nlmsg_type == RTM_DELLINK)
+    {
+	if_remove(ifi->ifi_index);
+	return;
+    }
+
+    name[0] = '\0';
+    mac = NULL;
+    mac_len = 0;
+    len = IFLA_PAYLOAD(nh);
+
+    for(rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+	if (rta->rta_type == IFLA_IFNAME)
+	{
+	    snprintf(name, sizeof(name), "%s", (char *) RTA_DATA(rta));
+	}
+	else if (rta->rta_type == IFLA_ADDRESS)
+	{
+	    mac = (unsigned char *) RTA_DATA(rta);
+	    mac_len = RTA_PAYLOAD(rta);
+	}
+    }
+
+    if (name[0] == '\0')
+    	return;
+
+    ife = if_find(ifi->ifi_index, name, TRUE);
+    ife->flags = ifi->ifi_flags;
+
+    /* Renamed */
+    if (strcmp(ife->name, name) != 0)
+	snprintf(ife->name, sizeof(ife->name), "%s", name);
+
+    if (mac != NULL)
+	set_mac(ife, mac, mac_len);
+
+    return;
+}
+
+
+/* Address added or removed (the IPv4 address is shown, IPv6 changes just prompt a refresh) */
+
+void addr_msg(struct nlmsghdr *nh)
+{
+    int len;
+    char ip[16];
+    struct ifaddrmsg *ifa;
+    struct rtattr *rta;
+    IfEntry *ife;
+
+    ifa = (struct ifaddrmsg *) NLMSG_DATA(nh);
+
+    if (ifa->ifa_family != AF_INET)
+    	return;
+
+    if ((ife = if_find(ifa->ifa_index, NULL, FALSE)) == NULL)
+    	return;
+
+    ip[0] = '\0';
+    len = IFA_PAYLOAD(nh);
+
+    for(rta = IFA_RTA(ifa); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+	if (rta->rta_type == IFA_LOCAL || (rta->rta_type == IFA_ADDRESS && ip[0] == '\0'))
+	    inet_ntop(AF_INET, RTA_DATA(rta), ip, sizeof(ip));
+    }
+
+    if (nh->nlmsg_type == RTM_NEWADDR)
+	strcpy(ife->ip, ip);
+    else if (strcmp(ife->ip, ip) == 0)
+	ife->ip[0] = '\0';
+
+    return;
+}
+
+
+/* Find an interface by index (or name if there is no index), optionally adding it */
+
+IfEntry * if_find(int ifindex, char *name, int add)
+{
+    int i;
+    IfEntry *ife;
+
+    for(i = 0; i < if_cnt; i++)
+    {
+	if (ifindex > 0 && ifs[i].ifindex == ifindex)
+	    return &(ifs[i]);
+
+	if (ifindex <= 0 && name != NULL && strcmp(ifs[i].name, name) == 0)
+	    return &(ifs[i]);
+    }
+
+    if (add == FALSE)
+    	return NULL;
+
+    if (if_cnt >= if_max)
+    {
+	if_max = (if_max == 0) ? 16 : if_max * 2;
+	ifs = (IfEntry *) realloc(ifs, if_max * sizeof(IfEntry));
+    }
+
+    ife = &(ifs[if_cnt++]);
+    memset(ife, 0, sizeof(IfEntry));
+    ife->ifindex = ifindex;
+    snprintf(ife->name, sizeof(ife->name), "%s", (name == NULL) ? "" : name);
+
+    return ife;
+}
+
+
+/* Remove an interface (order is kept) */
+
+void if_remove(int ifindex)
+{
+    int i;
+
+    for(i = 0; i < if_cnt; i++)
+    {
+	if (ifs[i].ifindex == ifindex)
+	{
+	    memmove(&(ifs[i]), &(ifs[i + 1]), (if_cnt - i - 1) * sizeof(IfEntry));
+	    if_cnt--;
+	    break;
+	}
+    }
+
+    return;
+}
+
+
+/* Hardware address as text (eg. 01:23:45:67:89:AB) */
+
+void set_mac(IfEntry *ife, unsigned char *addr, int len)
+{
+    int i;
+
+    if (len > 6)
+    	len = 6;
+
+    ife->mac[0] = '\0';
+
+    for(i = 0; i < len; i++)
+        sprintf((char *) &(ife->mac[i * 3]), (i < len - 1) ? "%02X:" : "%02X", addr[i]);
+
+    return;
+}
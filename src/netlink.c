@@ -0,0 +1,382 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:
+**  Network interface statistics for all links in one query.
+**  A netlink RTM_GETLINK dump returns the 64 bit counters (IFLA_STATS64) for every link.
+**  If netlink is not available /proc/net/dev is re-read (pread) from a descriptor kept open.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	Copy to the caller's array under a lock (sampler, monitor and ledger all query)
+**
+*/
+
+
+/* Defines */
+
+#define NL_BUF_SZ 32768
+#define PROC_NET_DEV "/proc/net/dev"
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#include <pthread.h>
+#include <gtk/gtk.h>
+#include <net_stats.h>
+
+
+/* Prototypes */
+
+int link_stats(LinkStats **, int *);
+int nl_link_stats();
+int proc_link_stats();
+LinkStats * next_link();
+void close_link_stats();
+
+extern void log_msg(char*, char*, char*, GtkWidget*);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-netlink.c ";
+static int nl_sock = -1;
+static int proc_fd = -1;
+static int nl_failed = FALSE;
+static unsigned int nl_seq = 0;
+static LinkStats *links = NULL;
+static int link_cnt = 0;
+static int link_max = 0;
+static pthread_mutex_t link_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/*
+** Get the current counters for all links into the caller's array (of size *ls_max, grown
+** as required). Callers may be on any thread. Returns the number of links or -1 on error.
+*/
+
+int link_stats(LinkStats **ls, int *ls_max)
+{
+    int r, n;
+
+    pthread_mutex_lock(&link_mutex);
+
+    link_cnt = 0;
+    r = FALSE;
+
+    if (nl_failed == FALSE)
+    {
+	if ((r = nl_link_stats()) == FALSE)
+	{
+	    /* Use the fallback from now on */
+	    nl_failed = TRUE;
+	    link_cnt = 0;
+	    log_msg("ERR0053", "netlink", NULL, NULL);
+	}
+    }
+
+    if (r == FALSE)
+    {
+	if ((r = proc_link_stats()) == FALSE)
+	{
+	    pthread_mutex_unlock(&link_mutex);
+	    return -1;
+	}
+    }
+
+    /* Copy out */
+    if (*ls_max < link_cnt)
+    {
+	*ls_max = link_max;
+	*ls = (LinkStats *) realloc(*ls, *ls_max * sizeof(LinkStats));
+    }
+
+    if (link_cnt > 0)
+	memcpy(*ls, links, link_cnt * sizeof(LinkStats));
+
+    n = link_cnt;
+    pthread_mutex_unlock(&link_mutex);
+
+    return n;
+}
+
+
+/* Netlink dump of all links */
+
+int nl_link_stats()
+{
+    int len, done;
+    char buf[NL_BUF_SZ];
+    struct
+    {
+	struct nlmsghdr nh;
+	struct ifinfomsg ifi;
+    } req;
+    struct sockaddr_nl sa;
+    struct nlmsghdr *nh;
+    struct ifinfomsg *ifi;
+    struct rtattr *rta;
+    struct rtnl_link_stats64 *st64;
+    struct rtnl_link_stats *st;
+    LinkStats *lnk;
+    int rta_len;
+
+    /* Socket is kept open */
+    if (nl_sock < 0)
+    {
+	if ((nl_sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE)) < 0)
+	    return FALSE;
+    }
+
+    /* Dump request */
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    req.nh.nlmsg_type = RTM_GETLINK;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nh.nlmsg_seq = ++nl_seq;
+    req.ifi.ifi_family = AF_UNSPEC;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.nl_family = AF_NETLINK;
+
+    if (sendto(nl_sock, &req, req.nh.nlmsg_len, 0, (struct sockaddr *) &sa, sizeof(sa)) < 0)
+    	return FALSE;
+
+    /* Replies */
+    done = FALSE;
+
+    while(done == FALSE)
+    {
+	if ((len = recv(nl_sock, buf, sizeof(buf), 0)) < 0)
+	{
+	    if (errno == EINTR)
+	    	continue;
+
+	    return FALSE;
+	}
+
+	for(nh = (struct nlmsghdr *) buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len))
+	{
+	    /* Ignore any stale replies */
+	    if (nh->nlmsg_seq != nl_seq)
+	    	continue;
+
+	    if (nh->nlmsg_type == NLMSG_DONE)
+	    {
+	    	done = TRUE;
+	    	break;
+	    }
+
+	    if (nh->nlmsg_type == NLMSG_ERROR)
+	    	return FALSE;
+
+	    if (nh->nlmsg_type != RTM_NEWLINK)
+	    	continue;
+
+	    ifi = (struct ifinfomsg *) NLMSG_DATA(nh);
+	    lnk = next_link();
+	    lnk->ifindex = ifi->ifi_index;
+	    st = NULL;
+	    st64 = NULL;
+
+	    rta_len = IFLA_PAYLOAD(nh);
+
+	    for(rta = IFLA_RTA(ifi); RTA_OK(rta, rta_len); rta = RTA_NEXT(rta, rta_len))
+	    {
+	    	switch(rta->rta_type)
+	    	{
+		    case IFLA_IFNAME:
+			snprintf(lnk->name, sizeof(lnk->name), "%s", (char *) RTA_DATA(rta));
+			break;
+
+		    case IFLA_STATS64:
+			st64 = (struct rtnl_link_stats64 *) RTA_DATA(rta);
+			break;
+
+		    case IFLA_STATS:
+			st = (struct rtnl_link_stats *) RTA_DATA(rta);
+			break;
+
+		    default:
+			break;
+	    	}
+	    }
+
+	    /* Prefer the 64 bit counters */
+	    if (st64 != NULL)
+	    {
+		lnk->rx_bytes = st64->rx_bytes;
+		lnk->tx_bytes = st64->tx_bytes;
+	    }
+	    else if (st != NULL)
+	    {
+		lnk->rx_bytes = st->rx_bytes;
+		lnk->tx_bytes = st->tx_bytes;
+		lnk->wrap32 = TRUE;
+	    }
+	    else
+	    {
+	    	link_cnt--;
+	    }
+	}
+    }
+
+    return TRUE;
+}
+
+
+/*
+** Fallback - /proc/net/dev, eg.
+**  Inter-|   Receive                            ...|  Transmit
+**   face |bytes    packets errs drop fifo frame ...|bytes    packets ...
+**    eth0: 1234567 8910    0    0    0    0     ...  7654321 ...
+*/
+
+int proc_link_stats()
+{
+    int i, n;
+    ssize_t len;
+    char buf[NL_BUF_SZ];
+    char *p, *line, *colon;
+    unsigned long long v[9];
+    LinkStats *lnk;
+
+    if (proc_fd < 0)
+    {
+	if ((proc_fd = open(PROC_NET_DEV, O_RDONLY | O_CLOEXEC)) < 0)
+	{
+	    log_msg("ERR0053", PROC_NET_DEV, NULL, NULL);
+	    return FALSE;
+	}
+    }
+
+    if ((len = pread(proc_fd, buf, sizeof(buf) - 1, 0)) <= 0)
+    	return FALSE;
+
+    buf[len] = '\0';
+
+    /* Skip the 2 header lines */
+    line = buf;
+
+    for(i = 0; i < 2 && line != NULL; i++)
+    {
+	if ((line = strchr(line, '\n')) != NULL)
+	    line++;
+    }
+
+    while(line != NULL && *line != '\0')
+    {
+	if ((colon = strchr(line, ':')) == NULL)
+	    break;
+
+	lnk = next_link();
+	lnk->ifindex = 0;
+
+	/* Name */
+	for(p = line; *p == ' '; p++);
+
+	n = (int) (colon - p);
+
+	if (n >= LINK_NAME_SZ)
+	    n = LINK_NAME_SZ - 1;
+
+	memcpy(lnk->name, p, n);
+	lnk->name[n] = '\0';
+
+	/* rx bytes is the 1st and tx bytes the 9th value */
+	p = colon + 1;
+
+	for(i = 0; i < 9; i++)
+	    v[i] = strtoull(p, &p, 10);
+
+	lnk->rx_bytes = v[0];
+	lnk->tx_bytes = v[8];
+
+	if ((line = strchr(p, '\n')) != NULL)
+	    line++;
+    }
+
+    return TRUE;
+}
+
+
+/* Next free entry in the link array */
+
+LinkStats * next_link()
+{
+    LinkStats *lnk;
+
+    if (link_cnt >= link_max)
+    {
+	link_max = (link_max == 0) ? 16 : link_max * 2;
+	links = (LinkStats *) realloc(links, link_max * sizeof(LinkStats));
+    }
+
+    lnk = &links[link_cnt++];
+    memset(lnk, 0, sizeof(LinkStats));
+
+    return lnk;
+}
+
+
+/* Close the netlink socket and /proc descriptor */
+
+void close_link_stats()
+{
+    pthread_mutex_lock(&link_mutex);
+
+    if (nl_sock >= 0)
+    {
+	close(nl_sock);
+	nl_sock = -1;
+    }
+
+    if (proc_fd >= 0)
+    {
+	close(proc_fd);
+	proc_fd = -1;
+    }
+
+    free(links);
+    links = NULL;
+    link_cnt = 0;
+    link_max = 0;
+
+    pthread_mutex_unlock(&link_mutex);
+
+    return;
+}
@@ -72,6 +72,9 @@ extern Bar * bar_create(BarChart *);
 extern int bar_segment_create(BarChart *, Bar *, char *, const GdkRGBA *, const GdkRGBA *, int, double);
 extern void free_pie_chart(PieChart *);
 extern void free_bar_chart(BarChart *);
+extern void chart_cache_inval(ChartCache *);
+extern void chart_lock();
+extern void chart_unlock();
 extern time_t date_tm_add(struct tm *, char *, int);
 extern int get_user_pref(char *, char **);
 
@@ -289,13 +292,19 @@ void create_charts(ServUsage *srv_usg, IspData *isp_data, MainUi *m_ui)
     char *p;
     Bar *bar;
 
-    /* Charts need to be recreated after refresh */
+    /* Charts need to be recreated after refresh (not while a chart worker is using them) */
+    chart_lock();
+
     if (m_ui->pie_chart != NULL)
     	free_pie_chart(m_ui->pie_chart);
 
     if (m_ui->bar_chart != NULL)
     	free_bar_chart(m_ui->bar_chart);
 
+    /* The cached chart image is now stale */
+    chart_cache_inval(&(m_ui->ov_cache));
+    gtk_widget_queue_draw(m_ui->graph_area);
+
     /* Pie Chart and slices (quota still available or excess) */
     val_str2dbl(srv_usg->total_bytes, &total, NULL, NULL);
     val_str2dbl(srv_usg->quota, &quota, NULL, NULL);
@@ -333,5 +342,7 @@ printf("%s quota %0.4f  rem %0.4f\n", debug_hdr, m_ui->days_quota, m_ui->days_re
     		       m_ui->days_quota - m_ui->days_rem);
     bar_segment_create(m_ui->bar_chart, bar, NULL, &WHITE, &DARK_MAROON, 9, m_ui->days_rem);
 
+    chart_unlock();
+
     return;
 }
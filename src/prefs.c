@@ -88,6 +88,7 @@ extern void OnPrefPieLbl(GtkToggleButton*, gpointer);
 extern void OnPrefPieLgd(GtkToggleButton*, gpointer);
 extern void OnPrefBarLbl(GtkToggleButton*, gpointer);
 extern void OnPrefVersion(GtkToggleButton*, gpointer);
+extern void OnPrefRefMode(GtkToggleButton*, gpointer);
 extern int OnSetRefresh(GtkWidget*, GdkEvent *, gpointer);
 extern void OnRefreshTxt(GtkEditable *, gchar *, gint, gpointer, gpointer);
 
@@ -209,6 +210,10 @@ GtkWidget * std_prefs(MainUi *m_ui)
 
     gtk_box_pack_start (GTK_BOX (vbox), tbox, FALSE, FALSE, 0);
 
+    /* Create refresh mode radio button(s) - adaptive follows the quota usage rate */
+    pref_radio("title_4", "Refresh Interval", REFRESH_MODE, 
+	       "Fixed", "Adaptive", NULL, 5, &vbox, m_ui);
+
     /* Save button */
     save_btn = gtk_button_new_with_label("Save");
     gtk_widget_set_margin_top(save_btn, 10);
@@ -285,6 +290,7 @@ void set_callback(GtkWidget *radio, int cback, MainUi *m_ui)
     	case 2: g_signal_connect (radio, "toggled", G_CALLBACK (OnPrefPieLgd), m_ui); break;
     	case 3: g_signal_connect (radio, "toggled", G_CALLBACK (OnPrefBarLbl), m_ui); break;
     	case 4: g_signal_connect (radio, "toggled", G_CALLBACK (OnPrefVersion), m_ui); break;
+    	case 5: g_signal_connect (radio, "toggled", G_CALLBACK (OnPrefRefMode), m_ui); break;
     	default: break;
     }
 
@@ -536,12 +542,55 @@ void set_default_prefs()
     if (p == NULL)
 	add_user_pref(REFRESH_TM, "30");
 
+    /* Refresh mode (fixed or adaptive) and adaptive bounds (mins) */
+    get_user_pref(REFRESH_MODE, &p);
+
+    if (p == NULL)
+	add_user_pref(REFRESH_MODE, "0");
+
+    get_user_pref(REFRESH_MIN, &p);
+
+    if (p == NULL)
+	add_user_pref(REFRESH_MIN, "5");
+
+    get_user_pref(REFRESH_MAX, &p);
+
+    if (p == NULL)
+	add_user_pref(REFRESH_MAX, "120");
+
     /* Version check labels */
     get_user_pref(OV_VER_LBL, &p);
 
     if (p == NULL)
 	add_user_pref(OV_VER_LBL, "0");
 
+    /* Log file segment size (KB), age (days) and total archive size (KB) */
+    get_user_pref(LOG_MAX_SZ, &p);
+
+    if (p == NULL)
+	add_user_pref(LOG_MAX_SZ, "1024");
+
+    get_user_pref(LOG_MAX_AGE, &p);
+
+    if (p == NULL)
+	add_user_pref(LOG_MAX_AGE, "7");
+
+    get_user_pref(LOG_CAP, &p);
+
+    if (p == NULL)
+	add_user_pref(LOG_CAP, "10240");
+
+    /* Network monitor sample interval (ms) and history kept (minutes) */
+    get_user_pref(MON_INTVL, &p);
+
+    if (p == NULL)
+	add_user_pref(MON_INTVL, "1000");
+
+    get_user_pref(MON_HIST, &p);
+
+    if (p == NULL)
+	add_user_pref(MON_HIST, "5");
+
     return;
 }
 
@@ -0,0 +1,249 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:
+**  Streaming rate statistics for a network device.
+**  Short and long term exponentially weighted averages, the true peak and percentiles
+**  (p50, p95, p99) over a sliding window from a log bucketed histogram of fixed size.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Includes */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <gtk/gtk.h>
+#include <net_stats.h>
+
+
+/* Prototypes */
+
+int rate_stats_init(RateStats *, double);
+void rate_stats_free(RateStats *);
+void rate_stats_add(RateStats *, double, double, double);
+void rate_percentiles(RateStats *);
+void slide_window(RateHist *, double);
+int rate_bucket(unsigned long long);
+double bucket_value(int);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-rate_stats.c ";
+static const double kbps_dv = 128.0;		// 1024.0/8.0
+
+
+
+/* Set up statistics with a percentile window of 'window' seconds */
+
+int rate_stats_init(RateStats *rs, double window)
+{
+    memset(rs, 0, sizeof(RateStats));
+
+    if ((rs->hist = (RateHist *) calloc(1, sizeof(RateHist))) == NULL)
+    	return FALSE;
+
+    rs->hist->slot_len = window / (double) RS_SLOTS;
+
+    return TRUE;
+}
+
+
+/* Free the histogram */
+
+void rate_stats_free(RateStats *rs)
+{
+    free(rs->hist);
+    rs->hist = NULL;
+
+    return;
+}
+
+
+/*
+** Add a rate (Kb/s) measured over 'dt' seconds at monotonic time 'ts'.
+** The averages are weighted by time so they do not depend on the sampling interval.
+*/
+
+void rate_stats_add(RateStats *rs, double kbps, double dt, double ts)
+{
+    int b;
+    RateHist *h;
+
+    /* Averages and peak */
+    if (rs->primed == FALSE)
+    {
+	rs->ewma_s = kbps;
+	rs->ewma_l = kbps;
+	rs->primed = TRUE;
+    }
+    else
+    {
+	rs->ewma_s += (kbps - rs->ewma_s) * (1.0 - exp(-dt / RS_TAU_S));
+	rs->ewma_l += (kbps - rs->ewma_l) * (1.0 - exp(-dt / RS_TAU_L));
+    }
+
+    if (kbps > rs->peak)
+    	rs->peak = kbps;
+
+    /* Window histogram */
+    if ((h = rs->hist) == NULL)
+    	return;
+
+    slide_window(h, ts);
+    b = rate_bucket((unsigned long long) (kbps * kbps_dv));
+    h->cnt[h->slot][b]++;
+    h->total[h->slot]++;
+
+    rate_percentiles(rs);
+
+    return;
+}
+
+
+/* Percentiles from all the slots in the window (one pass) */
+
+void rate_percentiles(RateStats *rs)
+{
+    int i, j, got50, got95;
+    unsigned long n, cum, r50, r95, r99;
+    RateHist *h;
+
+    h = rs->hist;
+
+    for(i = 0, n = 0; i < RS_SLOTS; i++)
+    	n += h->total[i];
+
+    if (n == 0)
+    	return;
+
+    /* Rank (1 based) of each percentile */
+    r50 = (unsigned long) ceil(0.50 * (double) n);
+    r95 = (unsigned long) ceil(0.95 * (double) n);
+    r99 = (unsigned long) ceil(0.99 * (double) n);
+    cum = 0;
+    got50 = FALSE;
+    got95 = FALSE;
+
+    for(j = 0; j < RS_BKT; j++)
+    {
+	for(i = 0; i < RS_SLOTS; i++)
+	    cum += h->cnt[i][j];
+
+	if (got50 == FALSE && cum >= r50)
+	{
+	    rs->p50 = bucket_value(j) / kbps_dv;
+	    got50 = TRUE;
+	}
+
+	if (got95 == FALSE && cum >= r95)
+	{
+	    rs->p95 = bucket_value(j) / kbps_dv;
+	    got95 = TRUE;
+	}
+
+	if (cum >= r99)
+	{
+	    rs->p99 = bucket_value(j) / kbps_dv;
+	    break;
+	}
+    }
+
+    return;
+}
+
+
+/* Move the window on, clearing any slots that have expired */
+
+void slide_window(RateHist *h, double ts)
+{
+    int i;
+
+    if (h->slot_start == 0.0)
+    {
+	h->slot_start = ts;
+	return;
+    }
+
+    for(i = 0; i < RS_SLOTS && ts - h->slot_start >= h->slot_len; i++)
+    {
+	h->slot = (h->slot + 1) % RS_SLOTS;
+	memset(h->cnt[h->slot], 0, sizeof(h->cnt[h->slot]));
+	h->total[h->slot] = 0;
+	h->slot_start += h->slot_len;
+    }
+
+    /* Long gap (eg. suspend), the whole window has gone */
+    if (ts - h->slot_start >= h->slot_len)
+	h->slot_start = ts;
+
+    return;
+}
+
+
+/*
+** Histogram bucket for a value. Values below 2 * RS_SUB have a bucket each, above that
+** each power of 2 is split into RS_SUB buckets.
+*/
+
+int rate_bucket(unsigned long long v)
+{
+    int m, b;
+
+    if (v < RS_SUB * 2)
+    	return (int) v;
+
+    m = 63 - __builtin_clzll(v);			// v >= 2^m, m >= 5
+    b = RS_SUB * 2 + (m - 5) * RS_SUB + (int) ((v >> (m - 4)) & (RS_SUB - 1));
+
+    if (b >= RS_BKT)
+    	b = RS_BKT - 1;
+
+    return b;
+}
+
+
+/* Representative (mid point) value for a bucket */
+
+double bucket_value(int b)
+{
+    int m, sub;
+    double low, width;
+
+    if (b < RS_SUB * 2)
+    	return (double) b;
+
+    m = 5 + (b - RS_SUB * 2) / RS_SUB;
+    sub = (b - RS_SUB * 2) % RS_SUB;
+    width = ldexp(1.0, m - 4);
+    low = (double) (RS_SUB + sub) * width;
+
+    return low + width / 2.0;
+}
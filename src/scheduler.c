@@ -0,0 +1,290 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:
+**  Job scheduler for the main loop (data refresh, connection retry, version check etc.).
+**  Jobs are kept in a deadline queue (binary heap on the monotonic due time) and a single
+**  GLib source has its ready time set to the earliest deadline, so the main loop only wakes
+**  when a job is actually due. Jobs run in the main loop and may re-schedule themselves.
+**  Adding a job that is already queued just moves its deadline.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Defines */
+
+#define SCHED_MAX 16
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gtk/gtk.h>
+#include <main.h>
+#include <defs.h>
+
+
+/* Types */
+
+typedef struct _sched_job
+{
+    int id;
+    gint64 due;				// Monotonic (micro secs)
+    void (*fn)(gpointer);
+    gpointer data;
+} SchedJob;
+
+
+/* Prototypes */
+
+int sched_add(int, long, void (*)(gpointer), gpointer);
+void sched_cancel(int);
+gint64 sched_due(int);
+void sched_close();
+gboolean sched_dispatch(GSource *, GSourceFunc, gpointer);
+int sched_find(int);
+void sched_remove(int);
+int sift_up(int);
+void sift_down(int);
+void sched_arm();
+
+extern void log_msg(char*, char*, char*, GtkWidget*);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-scheduler.c ";
+static SchedJob jobs[SCHED_MAX];
+static int job_cnt = 0;
+static GSource *sched_src = NULL;
+static GSourceFuncs sched_funcs = { NULL, NULL, sched_dispatch, NULL };
+
+
+
+/* Schedule (or re-schedule) a job to run in 'delay' milli secs */
+
+int sched_add(int id, long delay, void (*fn)(gpointer), gpointer data)
+{
+    int i;
+
+    if (sched_src == NULL)
+    {
+	sched_src = g_source_new(&sched_funcs, sizeof(GSource));
+	g_source_set_ready_time(sched_src, -1);
+	g_source_attach(sched_src, NULL);
+    }
+
+    if ((i = sched_find(id)) < 0)
+    {
+	if (job_cnt >= SCHED_MAX)
+	{
+	    sprintf(app_msg_extra, "Job queue full (%d). ", SCHED_MAX);
+	    log_msg("ERR0044", NULL, "ERR0044", NULL);
+	    return FALSE;
+	}
+
+	i = job_cnt++;
+	jobs[i].id = id;
+    }
+
+    jobs[i].due = g_get_monotonic_time() + ((gint64) delay * 1000);
+    jobs[i].fn = fn;
+    jobs[i].data = data;
+
+    /* Deadline may have moved either way */
+    sift_down(sift_up(i));
+    sched_arm();
+
+    return TRUE;
+}
+
+
+/* Remove a job if it is queued */
+
+void sched_cancel(int id)
+{
+    int i;
+
+    if ((i = sched_find(id)) < 0)
+    	return;
+
+    sched_remove(i);
+    sched_arm();
+
+    return;
+}
+
+
+/* When a job is due (monotonic micro secs), -1 if not queued */
+
+gint64 sched_due(int id)
+{
+    int i;
+
+    if ((i = sched_find(id)) < 0)
+    	return -1;
+
+    return jobs[i].due;
+}
+
+
+/* Drop all jobs and the source */
+
+void sched_close()
+{
+    job_cnt = 0;
+
+    if (sched_src != NULL)
+    {
+	g_source_destroy(sched_src);
+	g_source_unref(sched_src);
+	sched_src = NULL;
+    }
+
+    return;
+}
+
+
+/* Run everything that is due, then wait for the next deadline */
+
+gboolean sched_dispatch(GSource *src, GSourceFunc callback, gpointer user_data)
+{
+    gint64 now;
+    SchedJob job;
+
+    now = g_get_monotonic_time();
+
+    while(job_cnt > 0 && jobs[0].due <= now)
+    {
+	/* Dequeue before running as the job may queue itself again */
+	job = jobs[0];
+	sched_remove(0);
+	(*job.fn)(job.data);
+    }
+
+    sched_arm();
+
+    return G_SOURCE_CONTINUE;
+}
+
+
+/* Queue index for a job */
+
+int sched_find(int id)
+{
+    int i;
+
+    for(i = 0; i < job_cnt; i++)
+    {
+	if (jobs[i].id == id)
+	    return i;
+    }
+
+    return -1;
+}
+
+
+/* Remove a queue entry */
+
+void sched_remove(int i)
+{
+    job_cnt--;
+
+    if (i == job_cnt)
+    	return;
+
+    jobs[i] = jobs[job_cnt];
+    sift_down(sift_up(i));
+
+    return;
+}
+
+
+/* Heap ordering (earliest deadline at the top) */
+
+int sift_up(int i)
+{
+    int p;
+    SchedJob tmp;
+
+    while(i > 0)
+    {
+	p = (i - 1) / 2;
+
+	if (jobs[p].due <= jobs[i].due)
+	    break;
+
+	tmp = jobs[p];
+	jobs[p] = jobs[i];
+	jobs[i] = tmp;
+	i = p;
+    }
+
+    return i;
+}
+
+
+void sift_down(int i)
+{
+    int c;
+    SchedJob tmp;
+
+    while((c = (i * 2) + 1) < job_cnt)
+    {
+	if (c + 1 < job_cnt && jobs[c + 1].due < jobs[c].due)
+	    c++;
+
+	if (jobs[i].due <= jobs[c].due)
+	    break;
+
+	tmp = jobs[c];
+	jobs[c] = jobs[i];
+	jobs[i] = tmp;
+	i = c;
+    }
+
+    return;
+}
+
+
+/* Wake the main loop at the earliest deadline (or not at all) */
+
+void sched_arm()
+{
+    if (sched_src == NULL)
+    	return;
+
+    if (job_cnt == 0)
+	g_source_set_ready_time(sched_src, -1);
+    else
+	g_source_set_ready_time(sched_src, jobs[0].due);
+
+    return;
+}
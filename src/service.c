@@ -76,6 +76,7 @@ void free_srv_list(gpointer);
 int check_http_status(char *, int *, MainUi *);
 char * resp_status_desc(char *, MainUi *);
 ServUsage * get_service_usage();
+SrvPlan * get_service_plan();
 void set_service_retry_txt(MainUi *, char *);
 
 extern void log_msg(char*, char*, char*, GtkWidget*);
@@ -127,12 +128,23 @@ void serv_plan_details(int init, MainUi *m_ui)
 {  
     int i, unit_free;
     char *s;
+    GList *l;
     GtkWidget *item_lbl, *item_val;
     const char *item_names[] = { "Username:", "Plan Quota:", "Plan:", "Carrier:", "Speed:", "Usage Rating:", 
     				 "Rollover:", "Excess Cost:", "Excess Charging:", "Excess Shaping:", 
     				 "Excess Restrict:", "Plan Interval:", "Cost:" }; 
     const int item_cnt = 13;
 
+    /* Panel not shown yet (filled in when it is built) */
+    if (m_ui->plan_grid == NULL)
+    	return;
+
+    /* Panel built before the plan was known, the widgets are still to be created */
+    if ((l = gtk_container_get_children (GTK_CONTAINER (m_ui->plan_grid))) == NULL)
+    	init = TRUE;
+    else
+    	g_list_free (l);
+
     /* Display each service plan item found */
     for(i = 0; i < item_cnt; i++)
     {
@@ -206,6 +218,10 @@ void serv_plan_details(int init, MainUi *m_ui)
 	    free(s);
     }
 
+    /* Widgets added to a panel already shown */
+    if (init == TRUE)
+    	gtk_widget_show_all (m_ui->plan_grid);
+
     return;
 }
 
@@ -590,7 +606,6 @@ int load_usage_hist(char *xml, IspData *isp_data, MainUi *m_ui)
 	free(srv_usage.hist_usg_arr);
 
     srv_usage.hist_usg_arr = NULL;
-    srv_usage.last_cat_idx = 0;
     hday = 0;
 
     /* Determine the size of the array, round days up and include day 0 (+2) */
@@ -1266,6 +1281,14 @@ ServUsage * get_service_usage()
 }  
 
 
+/* Return a pointer to the service plan data */
+
+SrvPlan * get_service_plan()
+{
+    return &srv_plan;
+}  
+
+
 /* Return a pointer to the service usage details */
 
 void set_service_retry_txt(MainUi *_m_ui, char *buf)
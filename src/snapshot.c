@@ -0,0 +1,468 @@
+/*
+**  Copyright (C) 2017 Anthony Buckley
+** 
+**  This file is part of Inodeum.
+** 
+**  Inodeum is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**  
+**  Inodeum is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public License
+**  along with Inodeum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:
+**  Usage snapshot - the last usage and service plan details retrieved are saved to
+**  ~/.Inodeum/usage.snap so they can be shown straight away at the next start while the
+**  connection to the ISP is made. The file is a small header, the ISP username it belongs
+**  to, the strings (length then text, NULL as SNAP_NULL) and the history table as 64 bit
+**  values (8 byte aligned). It is removed with the stored credentials.
+**  It is mapped to read and every length is checked against the file size. Anything
+**  that does not look right is ignored and the application starts as before.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Defines */
+
+#define SNAP_FILE "usage.snap"
+#define SNAP_MAGIC 0x50414e53		// 'SNAP'
+#define SNAP_VERSION 2
+#define SNAP_USG_STRS 9
+#define SNAP_PLAN_STRS 16
+#define SNAP_STRS (SNAP_USG_STRS + SNAP_PLAN_STRS)
+#define SNAP_NULL 0xffffffff
+#define SNAP_MAX_DAYS 36600		// 100 years
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <gtk/gtk.h>
+#include <main.h>
+#include <isp.h>
+#include <file_util.h>
+#include <defs.h>
+
+
+/* Types */
+
+typedef struct _snap_hdr
+{
+    uint32_t magic;
+    uint32_t version;
+    int64_t saved_t;
+    uint32_t n_str;
+    uint32_t hist_days;
+} SnapHdr;
+
+
+/* Prototypes */
+
+int snapshot_save(char *);
+int snapshot_load(time_t *);
+int snapshot_owner(char *);
+void snapshot_remove();
+char * snapshot_fn();
+void snap_strings(char **, ServUsage *, SrvPlan *);
+int write_str(FILE *, char *);
+int read_str(FileBuf *, size_t *, char **);
+void set_fixed(char *, int, char *);
+
+extern char * app_dir_path();
+extern void log_msg(char*, char*, char*, GtkWidget*);
+extern int map_file(char *, FileBuf *);
+extern void unmap_file(FileBuf *);
+extern ServUsage * get_service_usage();
+extern SrvPlan * get_service_plan();
+extern time_t string2tm(char *, struct tm *);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-snapshot.c ";
+static char *snap_fn = NULL;
+static char *snap_user = NULL;			// ISP username of the snapshot saved or loaded
+
+
+
+/* Save the current usage and plan for the ISP user (written to a temporary file and renamed) */
+
+int snapshot_save(char *uname)
+{
+    int i, j, r, fh;
+    FILE *fd;
+    char *fn, *tmp_fn;
+    char *str[SNAP_STRS];
+    int64_t val;
+    long pad;
+    SnapHdr hdr;
+    ServUsage *srv_usg;
+    SrvPlan *srv_plan;
+
+    srv_usg = get_service_usage();
+    srv_plan = get_service_plan();
+
+    if (srv_usg->total_bytes == NULL || uname == NULL)
+    	return FALSE;
+
+    fn = snapshot_fn();
+    tmp_fn = (char *) malloc(strlen(fn) + 5);
+    sprintf(tmp_fn, "%s.tmp", fn);
+
+    /* Private - the ISP username and plan are in it */
+    fd = NULL;
+
+    if ((fh = open(tmp_fn, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600)) >= 0)
+    {
+	if ((fd = fdopen(fh, "w")) == NULL)
+	{
+	    close(fh);
+	    unlink(tmp_fn);
+	}
+    }
+
+    if (fd == NULL)
+    {
+	sprintf(app_msg_extra, "%s", strerror(errno));
+	log_msg("ERR0056", fn, "ERR0056", NULL);
+	free(tmp_fn);
+	return FALSE;
+    }
+
+    /* Header and strings */
+    memset(&hdr, 0, sizeof(SnapHdr));
+    hdr.magic = SNAP_MAGIC;
+    hdr.version = SNAP_VERSION;
+    hdr.saved_t = (int64_t) time(NULL);
+    hdr.n_str = SNAP_STRS;
+    hdr.hist_days = (srv_usg->hist_usg_arr == NULL) ? 0 : srv_usg->hist_days;
+
+    r = (fwrite(&hdr, sizeof(SnapHdr), 1, fd) == 1);
+
+    if (r == TRUE)
+    	r = write_str(fd, uname);
+
+    snap_strings(str, srv_usg, srv_plan);
+
+    for(i = 0; i < SNAP_STRS && r == TRUE; i++)
+    	r = write_str(fd, str[i]);
+
+    /* History table */
+    if (r == TRUE && (pad = ftell(fd) % sizeof(int64_t)) != 0)
+    {
+	val = 0;
+	r = (fwrite(&val, sizeof(int64_t) - pad, 1, fd) == 1);
+    }
+
+    for(i = 0; i < (int) hdr.hist_days && r == TRUE; i++)
+    {
+	for(j = 0; j < 5 && r == TRUE; j++)
+	{
+	    val = (int64_t) srv_usg->hist_usg_arr[i][j];
+	    r = (fwrite(&val, sizeof(int64_t), 1, fd) == 1);
+	}
+    }
+
+    if (fclose(fd) != 0)
+    	r = FALSE;
+
+    if (r == TRUE && rename(tmp_fn, fn) != 0)
+    	r = FALSE;
+
+    if (r == TRUE)
+    {
+	free(snap_user);
+	snap_user = strdup(uname);
+    }
+    else
+    {
+	sprintf(app_msg_extra, "%s", strerror(errno));
+	log_msg("ERR0056", fn, "ERR0056", NULL);
+	unlink(tmp_fn);
+    }
+
+    free(tmp_fn);
+
+    return r;
+}
+
+
+/* Load the last snapshot (if any) as the current usage and plan. The time it was saved is returned */
+
+int snapshot_load(time_t *saved_t)
+{
+    int i, j, ok;
+    size_t off;
+    char *uname;
+    char *str[SNAP_STRS];
+    const int64_t *vals;
+    long **arr;
+    struct tm tm;
+    FileBuf fb;
+    SnapHdr *hdr;
+    ServUsage *srv_usg;
+    SrvPlan *srv_plan;
+
+    if (map_file(snapshot_fn(), &fb) == FALSE)
+    	return FALSE;
+
+    /* Header */
+    hdr = (SnapHdr *) fb.buf;
+
+    if (fb.len < sizeof(SnapHdr) || hdr->magic != SNAP_MAGIC || hdr->version != SNAP_VERSION
+    	|| hdr->n_str != SNAP_STRS || hdr->hist_days > SNAP_MAX_DAYS)
+    {
+	unmap_file(&fb);
+	return FALSE;
+    }
+
+    /* Strings */
+    ok = TRUE;
+    off = sizeof(SnapHdr);
+    memset(str, 0, sizeof(str));
+
+    ok = read_str(&fb, &off, &uname);
+
+    if (ok == TRUE && uname == NULL)
+    	ok = FALSE;
+
+    for(i = 0; i < SNAP_STRS && ok == TRUE; i++)
+    	ok = read_str(&fb, &off, &(str[i]));
+
+    /* History table */
+    off = (off + sizeof(int64_t) - 1) & ~(sizeof(int64_t) - 1);
+
+    if (ok == TRUE && (off > fb.len || fb.len - off < (size_t) hdr->hist_days * 5 * sizeof(int64_t)))
+    	ok = FALSE;
+
+    /* The overview needs these (metered and unmetered are optional), rollover is yyyy-mm-dd */
+    if (ok == TRUE)
+    	ok = (str[0] != NULL && str[1] != NULL && str[2] != NULL && str[5] != NULL && str[6] != NULL);
+
+    if (ok == TRUE && strlen(str[0]) < 10)
+    	ok = FALSE;
+
+    /* Usage from a period that has rolled over is no use */
+    if (ok == TRUE && string2tm(str[0], &tm) < time(NULL))
+    	ok = FALSE;
+
+    if (ok == FALSE)
+    {
+	for(i = 0; i < SNAP_STRS; i++)
+	    free(str[i]);
+
+	free(uname);
+	unmap_file(&fb);
+	return FALSE;
+    }
+
+    /* Replace the current details */
+    srv_usg = get_service_usage();
+    srv_plan = get_service_plan();
+    memset(srv_usg, 0, sizeof(ServUsage));
+    memset(srv_plan, 0, sizeof(SrvPlan));
+
+    srv_usg->rollover_dt = str[0];
+    srv_usg->plan_interval = str[1];
+    srv_usg->quota = str[2];
+    srv_usg->metered_bytes = str[3];
+    srv_usg->unmetered_bytes = str[4];
+    srv_usg->total_bytes = str[5];
+    srv_usg->unit = str[6];
+    set_fixed(srv_usg->hist_from_dt, sizeof(srv_usg->hist_from_dt), str[7]);
+    set_fixed(srv_usg->hist_to_dt, sizeof(srv_usg->hist_to_dt), str[8]);
+
+    for(i = 0; i < 13; i++)
+    	srv_plan->srv_plan_item[i] = str[SNAP_USG_STRS + i];
+
+    set_fixed(srv_plan->quota_units, sizeof(srv_plan->quota_units), str[SNAP_USG_STRS + 13]);
+    set_fixed(srv_plan->plan_cost_units, sizeof(srv_plan->plan_cost_units), str[SNAP_USG_STRS + 14]);
+    set_fixed(srv_plan->excess_cost_units, sizeof(srv_plan->excess_cost_units), str[SNAP_USG_STRS + 15]);
+
+    /* History rows as load_usage_hist has them, totals recalculated */
+    vals = (const int64_t *) (fb.buf + off);
+
+    if (hdr->hist_days > 0)
+    {
+	arr = malloc(hdr->hist_days * sizeof(long *));
+
+	for(i = 0; i < (int) hdr->hist_days; i++)
+	{
+	    arr[i] = malloc(5 * sizeof(long));
+
+	    for(j = 0; j < 5; j++)
+	    {
+		arr[i][j] = (long) vals[i * 5 + j];
+		srv_usg->hist_tot_arr[j] += arr[i][j];
+	    }
+	}
+
+	srv_usg->hist_usg_arr = arr;
+	srv_usg->hist_days = hdr->hist_days;
+    }
+
+    free(snap_user);
+    snap_user = uname;
+
+    *saved_t = (time_t) hdr->saved_t;
+    unmap_file(&fb);
+
+    return TRUE;
+}
+
+
+/* Check the snapshot loaded belongs to the ISP user */
+
+int snapshot_owner(char *uname)
+{
+    if (snap_user == NULL || uname == NULL)
+    	return FALSE;
+
+    return (strcmp(snap_user, uname) == 0);
+}
+
+
+/* Remove the snapshot (eg. the credentials are removed) */
+
+void snapshot_remove()
+{
+    unlink(snapshot_fn());
+
+    free(snap_user);
+    snap_user = NULL;
+
+    return;
+}
+
+
+/* Snapshot file path */
+
+char * snapshot_fn()
+{
+    char *dir;
+
+    if (snap_fn == NULL)
+    {
+	dir = app_dir_path();
+	snap_fn = (char *) malloc(strlen(dir) + strlen(SNAP_FILE) + 2);
+	sprintf(snap_fn, "%s/%s", dir, SNAP_FILE);
+    }
+
+    return snap_fn;
+}
+
+
+/* The strings saved, in file order */
+
+void snap_strings(char **str, ServUsage *srv_usg, SrvPlan *srv_plan)
+{
+    int i;
+
+    str[0] = srv_usg->rollover_dt;
+    str[1] = srv_usg->plan_interval;
+    str[2] = srv_usg->quota;
+    str[3] = srv_usg->metered_bytes;
+    str[4] = srv_usg->unmetered_bytes;
+    str[5] = srv_usg->total_bytes;
+    str[6] = srv_usg->unit;
+    str[7] = srv_usg->hist_from_dt;
+    str[8] = srv_usg->hist_to_dt;
+
+    for(i = 0; i < 13; i++)
+    	str[SNAP_USG_STRS + i] = srv_plan->srv_plan_item[i];
+
+    str[SNAP_USG_STRS + 13] = srv_plan->quota_units;
+    str[SNAP_USG_STRS + 14] = srv_plan->plan_cost_units;
+    str[SNAP_USG_STRS + 15] = srv_plan->excess_cost_units;
+
+    return;
+}
+
+
+/* Write a string as its length and text */
+
+int write_str(FILE *fd, char *s)
+{
+    uint32_t len;
+
+    len = (s == NULL) ? SNAP_NULL : (uint32_t) strlen(s);
+
+    if (fwrite(&len, sizeof(uint32_t), 1, fd) != 1)
+    	return FALSE;
+
+    if (s == NULL || len == 0)
+    	return TRUE;
+
+    return (fwrite(s, len, 1, fd) == 1);
+}
+
+
+/* Read a string at the offset (advanced), checking it lies within the file */
+
+int read_str(FileBuf *fb, size_t *off, char **s)
+{
+    uint32_t len;
+
+    *s = NULL;
+
+    if (fb->len - *off < sizeof(uint32_t))
+    	return FALSE;
+
+    memcpy(&len, fb->buf + *off, sizeof(uint32_t));
+    *off += sizeof(uint32_t);
+
+    if (len == SNAP_NULL)
+    	return TRUE;
+
+    if (fb->len - *off < len)
+    	return FALSE;
+
+    *s = (char *) malloc(len + 1);
+    memcpy(*s, fb->buf + *off, len);
+    (*s)[len] = '\0';
+    *off += len;
+
+    return TRUE;
+}
+
+
+/* Copy a loaded string to a fixed size field and free it */
+
+void set_fixed(char *fld, int sz, char *s)
+{
+    if (s == NULL)
+    {
+	fld[0] = '\0';
+	return;
+    }
+
+    strncpy(fld, s, sz - 1);
+    fld[sz - 1] = '\0';
+    free(s);
+
+    return;
+}
@@ -65,7 +65,6 @@ int create_socket(IspData *, MainUi *);
 int send_request(char *, IspData *, MainUi *);
 int send_query(char *, IspData *, MainUi *);
 int recv_data(IspData *, MainUi *);
-int ip_address(char *, char [16], unsigned char [18]);
 
 extern void log_msg(char*, char*, char*, GtkWidget*);
 extern char * setup_get(char *, IspData *);
@@ -273,50 +272,3 @@ int recv_data(IspData *isp_data, MainUi *m_ui)
 
     return TRUE;
 }  
-
-
-/* Get the IP and MAC address for network device */
-
-int ip_address(char *dev, char ip[16], unsigned char mac[18])
-{
-    int i, r, fd;
-    char *p;
-    struct ifreq ifr;
-    const int hwaddr_len = 6;
-
-    fd = socket(AF_INET, SOCK_DGRAM, 0);
-
-    ifr.ifr_addr.sa_family = AF_INET;		 /* IPv4 IP address */
-    strncpy(ifr.ifr_name, dev, IFNAMSIZ-1);
-
-    r = ioctl(fd, SIOCGIFADDR, &ifr);
-
-    if (r < 0)
-    {
-	check_errno();
-	printf("Error: (%d) %s\n",  errno, strerror(errno));
-	close(fd);
-	return -1;
-    }
-
-    p = inet_ntoa(((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr);
-    strcpy(ip, p);
-
-    r = ioctl(fd, SIOCGIFHWADDR, &ifr);
-
-    if (r < 0)
-    {
-	printf("Error: (%d) %s\n",  errno, strerror(errno));
-	close(fd);
-	return -1;
-    }
-
-    for(i = 0; i < hwaddr_len; i++)
-        sprintf(&mac[i * 3], "%02X:", ((unsigned char *) ifr.ifr_hwaddr.sa_data)[i]);
-
-    mac[17] = '\0';
-
-    close(fd);
-
-    return 0;
-}
@@ -63,6 +63,16 @@ extern void clean_up(IspData *);
 extern void free_pie_chart(PieChart *);
 extern void free_bar_chart(BarChart *);
 extern void free_dev(void *);
+extern void close_link_stats();
+extern void free_dev_stats(MainUi *);
+extern int ledger_init();
+extern void ledger_close();
+extern void netdev_close();
+extern void chart_cache_free(ChartCache *);
+extern void chart_text_cache_free();
+extern void chart_lock();
+extern void chart_unlock();
+extern void free_line_graph(LineGraph *);
 
 
 /* Globals */
@@ -85,6 +95,9 @@ int main(int argc, char *argv[])
 
     main_ui(&isp_data, &m_ui);
 
+    /* Traffic ledger is kept while running */
+    ledger_init();
+
     gtk_main();  
 
     final(&isp_data, &m_ui);
@@ -106,13 +119,13 @@ void initialise(IspData *isp_data, MainUi *m_ui)
     if (! check_app_dir())
     	exit(-1);
 
+    /* Load user preferences (a default set if required). The log rotation limits are needed first */
+    read_user_prefs(NULL);
+
     /* Start session */
     if (! reset_log())
     	exit(-1);
 
-    /* Load user preferences (a default set if required) */
-    read_user_prefs(NULL);
-
     log_msg("MSG0001", NULL, NULL, NULL);
 
     return;
@@ -123,6 +136,9 @@ void initialise(IspData *isp_data, MainUi *m_ui)
 
 void final(IspData *isp_data, MainUi *m_ui)
 {
+    /* Write the last of the traffic ledger */
+    ledger_close();
+
     /* Close log file */
     log_msg("MSG0002", NULL, NULL, NULL);
     close_log();
@@ -159,15 +175,33 @@ void final(IspData *isp_data, MainUi *m_ui)
 	SSL_free(isp_data->ssl);
 	*/
 
+    chart_lock();
+
     if (m_ui->pie_chart != NULL)
 	free_pie_chart(m_ui->pie_chart);
 
     if (m_ui->bar_chart != NULL)
 	free_bar_chart(m_ui->bar_chart);
 
+    if (m_ui->hist_usg_graph != NULL)
+	free_line_graph(m_ui->hist_usg_graph);
+
+    m_ui->pie_chart = NULL;
+    m_ui->bar_chart = NULL;
+    m_ui->hist_usg_graph = NULL;
+
+    chart_cache_free(&(m_ui->ov_cache));
+    chart_cache_free(&(m_ui->hist_cache));
+    chart_text_cache_free();
+    chart_unlock();
+
     if (m_ui->ndevs != NULL)
 	g_list_free_full (m_ui->ndevs, (GDestroyNotify) free_dev);
 
+    free_dev_stats(m_ui);
+    close_link_stats();
+    netdev_close();
+
     clean_up(isp_data);
 
     return;
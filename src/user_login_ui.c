@@ -28,6 +28,7 @@
 ** History
 **	02-Apr-2017	Initial code
 **	19-Oct-2020	Changes to convert from gnome keyring to gnome libsecret
+**	19-Oct-2026	Remove the saved usage with the credentials
 **
 */
 
@@ -107,12 +108,11 @@ extern void OnQuit(GtkWidget*, gpointer);
 extern int ssl_service_details(IspData *, MainUi *);
 extern void disable_login(MainUi *);
 extern void load_overview(IspData *isp_data, MainUi *m_ui);
-extern void show_panel(GtkWidget *, MainUi *);
+extern void show_panel(GtkWidget **, MainUi *);
 extern void start_usage_mon(IspData *, MainUi *);
-extern int refresh_thread(MainUi *);
-extern void add_main_loop(MainUi *);
 extern void set_connect_btns(MainUi *, int);
 extern void set_css();
+extern void snapshot_remove();
 
 
 /* Globals */
@@ -333,6 +333,9 @@ int delete_user_creds(IspData *isp_data, MainUi *m_ui)
     if (clear_isp_pw(isp_data, m_ui) == FALSE)
 	return FALSE;
 
+    /* The saved usage goes with them */
+    snapshot_remove();
+
     log_msg("INF0015", "removed", NULL, NULL);
     return TRUE;
 }
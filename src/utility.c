@@ -32,14 +32,18 @@
 **
 ** History
 **	09-Jan-2017	Initial code
+**	19-Oct-2026	Log file rotation with compressed archives
 **
 */
 
 
 /* Defines */
 
+#define _GNU_SOURCE
 #define ERR_FILE
 #define MAX_SETTING 50
+#define MAX_LOG_SEG 20
+#define LOG_RETRY 3600			// Secs before another rotation is tried after a failure
 
 
 /* Includes */
@@ -55,6 +59,9 @@
 #include <errno.h>
 #include <time.h>
 #include <math.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <pthread.h>
 #include <gtk/gtk.h>
 #include <defs.h>
 
@@ -63,7 +70,15 @@
 
 int check_app_dir();
 int reset_log();
+int rotate_log();
+int check_log_rotate(long);
+time_t log_start_tm(char *);
+int compress_log(char *, char *);
+void cap_log_archives();
+char * log_segment(int);
+long log_pref_val(char *, long);
 void log_msg(char*, char*, char*, GtkWidget*);
+void log_write(char *, char *);
 void app_msg(char*, char *, GtkWidget*);
 void log_status_msg(char *, char *, char *, char *, GtkWidget *);
 void info_dialog(GtkWidget *, char *, char *);
@@ -83,12 +98,11 @@ void set_sz_abbrev(char *s);
 int check_errno();
 void strlower(char *, char *);
 int stat_file(char *, struct stat *);
-long read_file_all(char *, char *);
 FILE * open_file(char *, char *);
-int read_file(FILE *, char *, int);
 GtkWidget * find_widget_by_data(GtkWidget *, char *, const gchar *, char *);
 
 extern void cur_date_str(char *, int, char *);
+extern int get_user_pref(char *, char **);
 
 
 /* Globals */
@@ -100,6 +114,7 @@ static const char *app_messages[][2] =
     { "MSG0003", "%s "},
     { "MSG0004", "Warning: Inconsistent 'Unit' encountered - %s. "},
     { "MSG0005", "The Service Plan has changed significantly. Please restart Inodeum. "},
+    { "MSG0006", "Log file rotated. Previous entries archived to %s "},
     { "INF0001", "Connection error (see log file) %s "},
     { "INF0002", "Service query error (see log file) %s "},
     { "INF0003", "Connecting... %s "},
@@ -168,15 +183,23 @@ static const char *app_messages[][2] =
     { "ERR0049", "Failed to get ISP login Password for %s. "},
     { "ERR0050", "Failed to store ISP login / Password for %s. "},
     { "ERR0051", "Keyring Convert Error: %s. "},
+    { "ERR0052", "Failed to archive log file: %s "},
+    { "ERR0053", "Network statistics not available from %s. "},
+    { "ERR0054", "Failed to write traffic ledger %s. "},
+    { "ERR0055", "Packet capture not available on %s. "},
+    { "ERR0056", "Failed to save usage snapshot %s. "},
     { "ERR9998", "Error: %s. "},
     { "ERR9999", "Error - Unknown error message given. "}			// NB - MUST be last
 };
 
-static const int Msg_Count = 75;
+static const int Msg_Count = 81;
 static char *Home;
 static char *logfile = NULL;
 static char *app_dir;
 static FILE *lf = NULL;
+static time_t log_start_t;
+static time_t log_retry_t = 0;
+static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int app_dir_len;
 static const char *debug_hdr = "DEBUG-utility.c ";
 static GList *open_ui_list_head = NULL;
@@ -209,14 +232,47 @@ void app_msg(char *msg_id, char *opt_str, GtkWidget *window)
 }
 
 
-/* Add a message to the log file and optionally display a popup */
+/*
+** Add a message to the log file and optionally display a popup.
+** May be called from other threads (eg. the network sampler) so the write and any log
+** rotation are done under a lock.
+*/
 
 void log_msg(char *msg_id, char *opt_str, char *sys_msg_id, GtkWidget *window)
+{
+    pthread_mutex_lock(&log_mutex);
+
+    log_write(msg_id, opt_str);
+
+    /* Start a new log segment if this one is now too big or too old */
+    if (lf != stderr && time(NULL) >= log_retry_t)
+    {
+	if (check_log_rotate(ftell(lf)) == TRUE)
+	    rotate_log();
+    }
+
+    pthread_mutex_unlock(&log_mutex);
+
+    /* Optional display */
+    if (sys_msg_id && window && logfile)
+    {
+    	sprintf(app_msg_extra, "\nLog file (%s) may contain more details.", logfile);
+    	app_msg(sys_msg_id, opt_str, window);
+    }
+
+    return;
+}
+
+
+/* Write a message (and any extra details) to the log file. The caller holds the log lock */
+
+void log_write(char *msg_id, char *opt_str)
 {
     char date_str[50];
+    char log_txt[512];
 
     /* Lookup the error */
-    get_msg(msg, msg_id, opt_str);
+    get_msg(log_txt, msg_id, opt_str);
 
     /* Log the message */
     cur_date_str(date_str, sizeof(date_str), "%d-%b-%Y %I:%M:%S %p");
@@ -225,7 +281,7 @@ void log_msg(char *msg_id, char *opt_str, char *sys_msg_id, GtkWidget *window)
     if (lf == NULL)
     	lf = stderr;
 
-    fprintf(lf, "%s - %s\n", date_str, msg);
+    fprintf(lf, "%s - %s\n", date_str, log_txt);
 
     if (strlen(app_msg_extra) > 0)
 	fprintf(lf, "%s\n", app_msg_extra);
@@ -235,13 +291,6 @@ void log_msg(char *msg_id, char *opt_str, char *sys_msg_id, GtkWidget *window)
     /* Reset global error details */
     app_msg_extra[0] = '\0';
 
-    /* Optional display */
-    if (sys_msg_id && window && logfile)
-    {
-    	sprintf(app_msg_extra, "\nLog file (%s) may contain more details.", logfile);
-    	app_msg(sys_msg_id, opt_str, window);
-    }
-
     return;
 }
 
@@ -282,17 +331,32 @@ void info_dialog(GtkWidget *window, char *msg, char *opt)
 }
 
 
-/* Reset the log file */
+/* Open the log file for the session. Previous sessions are kept (append) and rotated if required */
 
 int reset_log()
 {
+    struct stat fileStat;
+
     logfile = (char *) malloc(strlen(Home) + (strlen(TITLE) * 2) + 10);
     sprintf(logfile, "%s/.%s/%s.log", Home, TITLE, TITLE);
 
-    if ((lf = fopen(logfile, "w")) == (FILE *) NULL)
+    /* Rotate an existing log first if it has grown too big or is too old */
+    if (stat(logfile, &fileStat) == 0 && fileStat.st_size > 0)
     {
-	log_msg("MSG0001", logfile, NULL, NULL);
+	log_start_t = log_start_tm(logfile);
+
+	if (check_log_rotate((long) fileStat.st_size) == TRUE)
+	{
+	    if (compress_log(logfile, NULL) == FALSE)
+		fprintf(stderr, "%s: Failed to archive log file - %s\n", TITLE, logfile);
+	}
+    }
+
+    if ((lf = fopen(logfile, "a")) == (FILE *) NULL)
+    {
+	log_msg("ERR0001", logfile, NULL, NULL);
 	free(logfile);
+	logfile = NULL;
 	return FALSE;
     }
     else
@@ -300,15 +364,285 @@ int reset_log()
     	g_print("%s: See Log file - %s for all details.\n", TITLE, logfile);
     }
 
+    if (ftell(lf) == 0)
+	log_start_t = time(NULL);
+
+    return TRUE;
+}
+
+
+/*
+** Check if the current log segment has reached the size (KB) or age (days) limits.
+** A zero limit preference means no limit.
+*/
+
+int check_log_rotate(long sz)
+{
+    long max_sz, max_age;
+
+    max_sz = log_pref_val(LOG_MAX_SZ, 1024) * 1024;
+    max_age = log_pref_val(LOG_MAX_AGE, 7) * 86400;
+
+    if (max_sz > 0 && sz >= max_sz)
+    	return TRUE;
+
+    if (max_age > 0 && log_start_t > 0 && (time(NULL) - log_start_t) >= max_age)
+    	return TRUE;
+
+    return FALSE;
+}
+
+
+/* Archive the current log segment and start a new one. The caller holds the log lock */
+
+int rotate_log()
+{
+    int r;
+    char *arch_fn;
+
+    fclose(lf);
+    lf = NULL;
+
+    arch_fn = (char *) malloc(strlen(logfile) + 10);
+    r = compress_log(logfile, arch_fn);
+
+    /* Reopen (a failed archive just carries on in the same segment) */
+    if ((lf = fopen(logfile, "a")) == (FILE *) NULL)
+    {
+	lf = stderr;
+	log_write("ERR0001", logfile);
+	free(arch_fn);
+	return FALSE;
+    }
+
+    /* A failure is not tried again for a while (the archives are untouched) */
+    if (r == TRUE)
+    {
+	log_start_t = time(NULL);
+	log_write("MSG0006", arch_fn);
+    }
+    else
+    {
+	log_retry_t = time(NULL) + LOG_RETRY;
+	log_write("ERR0052", logfile);
+    }
+
+    free(arch_fn);
+
+    return r;
+}
+
+
+/*
+** Gzip the log to a temporary archive, then shift the existing archives down (.1.gz -> .2.gz
+** etc.) and rename it to .1.gz. Nothing is moved unless the compress worked.
+** The oldest archives are removed to keep within the total size limit.
+*/
+
+int compress_log(char *fn, char *arch_fn)
+{
+    int i, len;
+    FILE *fp;
+    gzFile gz;
+    char *old_fn, *new_fn, *tmp_fn;
+    char buf[8192];
+
+    if ((fp = fopen(fn, "r")) == (FILE *) NULL)
+	return FALSE;
+
+    /* Compress */
+    tmp_fn = (char *) malloc(strlen(fn) + 10);
+    sprintf(tmp_fn, "%s.tmp.gz", fn);
+
+    if ((gz = gzopen(tmp_fn, "wb")) == NULL)
+    {
+	fclose(fp);
+	free(tmp_fn);
+	return FALSE;
+    }
+
+    while((len = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+	if (gzwrite(gz, buf, len) != len)
+	{
+	    gzclose(gz);
+	    fclose(fp);
+	    unlink(tmp_fn);
+	    free(tmp_fn);
+	    return FALSE;
+	}
+    }
+
+    fclose(fp);
+
+    if (gzclose(gz) != Z_OK)
+    {
+	unlink(tmp_fn);
+	free(tmp_fn);
+	return FALSE;
+    }
+
+    /* Make room for the new archive */
+    old_fn = (char *) malloc(strlen(fn) + 10);
+    new_fn = (char *) malloc(strlen(fn) + 10);
+
+    sprintf(old_fn, "%s.%d.gz", fn, MAX_LOG_SEG);
+    unlink(old_fn);
+
+    for(i = MAX_LOG_SEG - 1; i > 0; i--)
+    {
+	sprintf(old_fn, "%s.%d.gz", fn, i);
+	sprintf(new_fn, "%s.%d.gz", fn, i + 1);
+	rename(old_fn, new_fn);
+    }
+
+    sprintf(new_fn, "%s.1.gz", fn);
+
+    if (rename(tmp_fn, new_fn) != 0)
+    {
+	unlink(tmp_fn);
+	free(tmp_fn);
+	free(old_fn);
+	free(new_fn);
+	return FALSE;
+    }
+
+    /* Remove the current log (a new one is created on reopen and readers keep the old one) */
+    unlink(fn);
+
+    if (arch_fn != NULL)
+	strcpy(arch_fn, new_fn);
+
+    free(tmp_fn);
+    free(old_fn);
+    free(new_fn);
+
+    cap_log_archives();
+
     return TRUE;
 }
 
 
+/* Remove the oldest archives once the total size of archives exceeds the limit (KB) */
+
+void cap_log_archives()
+{
+    int i;
+    long cap, tot;
+    char *fn;
+    struct stat fileStat;
+
+    cap = log_pref_val(LOG_CAP, 10240) * 1024;
+    tot = 0;
+
+    if (cap <= 0)
+    	return;
+
+    for(i = 1; i <= MAX_LOG_SEG; i++)
+    {
+	if ((fn = log_segment(i)) == NULL)
+	    continue;
+
+	if (stat(fn, &fileStat) == 0)
+	{
+	    tot += (long) fileStat.st_size;
+
+	    if (tot > cap && i > 1)
+		unlink(fn);
+	}
+
+	free(fn);
+    }
+
+    return;
+}
+
+
+/* Date and time of the first entry in a log file */
+
+time_t log_start_tm(char *fn)
+{
+    FILE *fp;
+    char buf[60];
+    char *p;
+    struct tm tm;
+
+    if ((fp = fopen(fn, "r")) == (FILE *) NULL)
+    	return 0;
+
+    p = fgets(buf, sizeof(buf), fp);
+    fclose(fp);
+
+    if (p == NULL)
+    	return 0;
+
+    memset(&tm, 0, sizeof(struct tm));
+    tm.tm_isdst = -1;
+
+    if (strptime(buf, "%d-%b-%Y %I:%M:%S %p", &tm) == NULL)
+    	return 0;
+
+    return mktime(&tm);
+}
+
+
+/*
+** Return the name of a log segment - 0 is the current log, 1 the most recent archive and so on.
+** NULL if the segment does not exist. The caller must free the name.
+*/
+
+char * log_segment(int n)
+{
+    char *fn;
+    struct stat fileStat;
+
+    if (logfile == NULL || n < 0 || n > MAX_LOG_SEG)
+    	return NULL;
+
+    fn = (char *) malloc(strlen(logfile) + 10);
+
+    if (n == 0)
+	strcpy(fn, logfile);
+    else
+	sprintf(fn, "%s.%d.gz", logfile, n);
+
+    if (stat(fn, &fileStat) < 0)
+    {
+    	free(fn);
+    	return NULL;
+    }
+
+    return fn;
+}
+
+
+/* Numeric log preference or a default if not set */
+
+long log_pref_val(char *key, long dflt)
+{
+    char *p;
+
+    get_user_pref(key, &p);
+
+    if (p == NULL)
+    	return dflt;
+
+    return atol(p);
+}
+
+
 /* Close the log file and free any memory */
 
 void close_log()
 {
-    fclose(lf);
+    pthread_mutex_lock(&log_mutex);
+
+    if (lf != NULL && lf != stderr)
+	fclose(lf);
+
+    lf = NULL;
+    pthread_mutex_unlock(&log_mutex);
+
     free(logfile);
     free(app_dir);
 
@@ -704,41 +1038,6 @@ int stat_file(char *fn, struct stat *buf)
 }
 
 
-/* Read an entire file */
-
-long read_file_all(char *fn, char *s)
-{
-    long sz;
-    FILE *fp;
-    struct stat buf;
-
-    /* Get file size */
-    if (stat_file(fn, &buf) == FALSE)
-    	return -1;
-
-    sz = (long) buf.st_size;
-    s = (char *) malloc(sz + 1);
-
-    /* Open */
-    fp = fopen(fn, "r");
-
-    if (! fp)
-    	return -1;
-    
-    /* Read */
-    if (fgets(s, sz, fp) == NULL)
-    {
-    	fclose(fp);
-    	return -1;
-    };
-
-    /* Close */
-    fclose(fp);
-
-    return sz;
-}
-
-
 /* Open a file */
 
 FILE * open_file(char *fn, char *op)
@@ -755,39 +1054,6 @@ FILE * open_file(char *fn, char *op)
 }
 
 
-/* Read a file */
-
-int read_file(FILE *fd, char *buf, int sz_len)
-{
-    int i, max;
-    char c;
-
-    i = 0;
-    max = sz_len - 1;
-    buf[0] = '\0';
-    
-    while((c = fgetc(fd)) != EOF)
-    {
-    	buf[i++] = c;
-
-    	if (i >= max)
-	    break;
-    }
-
-    buf[i] = '\0';
-
-    if (c == EOF)
-    {
-	fclose(fd);
-	return (int) c;
-    }
-    else
-    {
-	return i;
-    }
-}
-
-
 /* Search for a child widget using object data for the widget */
 
 GtkWidget * find_widget_by_data(GtkWidget *parent_contnr, char *nm, const gchar *data_key, char *data_val)
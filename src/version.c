@@ -26,6 +26,7 @@
 **
 ** History
 **	08-May-2019	Initial code
+**	19-Oct-2026	New version text kept for the About panel (built on first view)
 */
 
 
@@ -309,7 +310,7 @@ int get_version(BIO *web, VersionData *ver, MainUi *m_ui)
 {  
     char *xml = NULL;
     char *s;
-    char latestv[20], lbl[50];
+    char latestv[20];
     int i, r, html_code;
 
     /* Read xml */
@@ -344,8 +345,10 @@ int get_version(BIO *web, VersionData *ver, MainUi *m_ui)
     /* Notify if version changed */
     if (strcmp(VERSION, latestv) != 0)
     {
-    	sprintf(lbl, "New version: %s available", latestv);
-    	gtk_label_set_text (GTK_LABEL(m_ui->new_vers_info), lbl);
+    	sprintf(m_ui->new_vers, "New version: %s available", latestv);
+
+    	if (m_ui->new_vers_info != NULL)
+	    gtk_label_set_text (GTK_LABEL(m_ui->new_vers_info), m_ui->new_vers);
 
     	sprintf(app_msg_extra, 
     		"\nA new version of %s is available for download.\n"
@@ -19,13 +19,19 @@
 
 
 
+
 /*
-** Description:	View a file in a scrollable viewing window
+** Description:	View a file in a scrollable viewing window.
+**		The file is memory mapped and a line offset index is built in the background.
+**		Only the lines visible in the window are drawn, directly from the mapping.
 **
 ** Author:	Anthony Buckley
 **
 ** History
 **	19-Jun-2014	Initial code
+**	19-Oct-2026	Read compressed (gzip) log archives
+**	19-Oct-2026	Memory mapped file, line index, paged display, tail follow and search
+**	19-Oct-2026	Only valid UTF-8 passed to cairo
 **
 */
 
@@ -33,6 +39,10 @@
 
 /* Defines */
 
+#define _GNU_SOURCE
+#define IDX_BATCH 4096
+#define MAX_LINE_DISP 1024
+
 
 /* Includes */
 #include <stdlib.h>  
@@ -40,28 +50,77 @@
 #include <libgen.h>  
 #include <gtk/gtk.h>  
 #include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
 #include <defs.h>
 
 
+/* Types */
+
+typedef struct _view_file
+{
+    char *fn;
+    int fd;				// -1 for a decompressed archive
+    char *map;				// File contents
+    size_t map_len;
+    size_t map_sz;			// Size of the mapping
+    size_t idx_len;			// Bytes indexed so far
+    long *line_off;			// Start offset of each line
+    long line_cnt, line_max;
+    int idx_busy;
+    int stop;
+    pthread_t idx_tid;
+    pthread_mutex_t idx_mutex;
+    guint idx_tmr, follow_tmr;
+    long match_line;
+    size_t match_off;
+    double line_ht;
+    GtkWidget *draw_area;
+    GtkWidget *search_ent;
+    GtkWidget *follow_chk;
+    GtkWidget *status_lbl;
+    GtkAdjustment *adj;
+} ViewFile;
+
+
 /* Prototypes */
 
 GtkWidget* view_file_main(char  *);
 GtkWidget* view_file_ui(char *);
 int view_file_init(char  *);
+int map_view_file(ViewFile *);
+int gz_view_file(ViewFile *);
+void unmap_view_file(ViewFile *);
+void start_index(ViewFile *);
+void * index_thread(void *);
+void index_lines(ViewFile *);
+long disp_line_cnt(ViewFile *);
+long offset_line(ViewFile *, size_t);
+void set_view_status(ViewFile *);
+gboolean index_progress(gpointer);
+gboolean follow_tail(gpointer);
+gboolean OnViewDraw(GtkWidget *, cairo_t *, gpointer);
+gboolean OnViewScroll(GtkWidget *, GdkEventScroll *, gpointer);
+void OnViewScrollChg(GtkAdjustment *, gpointer);
+void OnViewFind(GtkWidget *, gpointer);
+void OnViewFollow(GtkToggleButton *, gpointer);
 void OnViewFileClose(GtkWidget*, gpointer);
 GtkWidget* view_file_ui_menu(GtkWidget *);
 
 extern void register_window(GtkWidget *);
 extern void deregister_window(GtkWidget *);
-extern FILE * open_file(char *, char *);
-extern int read_file(FILE *, char *, int);
+extern int check_errno();
+extern void log_msg(char*, char*, char*, GtkWidget*);
 
 
 /* Globals */
 
 static const char *debug_hdr = "DEBUG-view_file_ui.c ";
-static char *viewfile;
-static FILE *fd = NULL;
+static ViewFile *vf = NULL;
 
 
 /* Display file contents */
@@ -81,6 +140,9 @@ GtkWidget* view_file_main(char *fn)
     /* Register the window */
     register_window(view_file_window);
 
+    /* Index the lines in the background */
+    start_index(vf);
+
     return view_file_window;
 }
 
@@ -89,11 +151,390 @@ GtkWidget* view_file_main(char *fn)
 
 int view_file_init(char *fn)
 {
-    /* Open the file for read */
-    if ((fd = open_file(fn, "r")) == (FILE *) NULL)
+    int r;
+
+    vf = (ViewFile *) malloc(sizeof(ViewFile));
+    memset(vf, 0, sizeof(ViewFile));
+    vf->fd = -1;
+    vf->match_line = -1;
+    vf->fn = strdup(fn);
+    pthread_mutex_init(&(vf->idx_mutex), NULL);
+
+    /* Map the file (archives are decompressed into anonymous memory) */
+    if (strlen(fn) > 3 && strcmp(fn + strlen(fn) - 3, ".gz") == 0)
+	r = gz_view_file(vf);
+    else
+	r = map_view_file(vf);
+
+    if (r == FALSE)
+    {
+	pthread_mutex_destroy(&(vf->idx_mutex));
+	free(vf->fn);
+	free(vf);
+	vf = NULL;
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* Map a plain file for read. An empty file has no mapping until it grows */
+
+int map_view_file(ViewFile *vf)
+{
+    struct stat fileStat;
+
+    if (vf->fd < 0)
+    {
+	if ((vf->fd = open(vf->fn, O_RDONLY)) < 0)
+	{
+	    check_errno();
+	    return FALSE;
+	}
+    }
+
+    if (fstat(vf->fd, &fileStat) < 0)
+    {
+	check_errno();
+	return FALSE;
+    }
+
+    vf->map = NULL;
+    vf->map_len = (size_t) fileStat.st_size;
+    vf->map_sz = vf->map_len;
+
+    if (vf->map_len == 0)
+    	return TRUE;
+
+    vf->map = mmap(NULL, vf->map_len, PROT_READ, MAP_SHARED, vf->fd, 0);
+
+    if (vf->map == MAP_FAILED)
+    {
+	vf->map = NULL;
+	vf->map_len = 0;
+	vf->map_sz = 0;
+	check_errno();
 	return FALSE;
+    }
 
-    viewfile = fn;
+    madvise(vf->map, vf->map_len, MADV_SEQUENTIAL);
+
+    return TRUE;
+}
+
+
+/* Decompress a gzip archive into an anonymous mapping */
+
+int gz_view_file(ViewFile *vf)
+{
+    int n;
+    size_t sz;
+    char *p;
+    gzFile gz;
+
+    if ((gz = gzopen(vf->fn, "r")) == NULL)
+    {
+	check_errno();
+	return FALSE;
+    }
+
+    sz = 1024 * 1024;
+    vf->map = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    vf->map_len = 0;
+
+    while(vf->map != MAP_FAILED)
+    {
+	if (vf->map_len == sz)
+	{
+	    p = mremap(vf->map, sz, sz * 2, MREMAP_MAYMOVE);
+
+	    if (p == MAP_FAILED)
+	    	break;
+
+	    vf->map = p;
+	    sz *= 2;
+	}
+
+	if ((n = gzread(gz, vf->map + vf->map_len, sz - vf->map_len)) <= 0)
+	    break;
+
+	vf->map_len += n;
+    }
+
+    gzclose(gz);
+
+    if (vf->map == MAP_FAILED)
+    {
+	vf->map = NULL;
+	vf->map_len = 0;
+	check_errno();
+	return FALSE;
+    }
+
+    vf->map_sz = sz;
+
+    return TRUE;
+}
+
+
+/* Release the mapping */
+
+void unmap_view_file(ViewFile *vf)
+{
+    if (vf->map == NULL)
+    	return;
+
+    munmap(vf->map, vf->map_sz);
+
+    vf->map = NULL;
+
+    return;
+}
+
+
+/* Start (or continue) indexing the line offsets in a background thread */
+
+void start_index(ViewFile *vf)
+{
+    vf->idx_busy = TRUE;
+
+    if (pthread_create(&(vf->idx_tid), NULL, &index_thread, vf) != 0)
+    {
+	/* Index on the main loop instead */
+	index_lines(vf);
+	vf->idx_busy = FALSE;
+	gtk_adjustment_set_upper (vf->adj, (double) disp_line_cnt(vf));
+	set_view_status(vf);
+	return;
+    }
+
+    vf->idx_tmr = g_timeout_add(250, index_progress, vf);
+
+    return;
+}
+
+
+/* Background indexing */
+
+void * index_thread(void *arg)
+{
+    ViewFile *vf;
+
+    vf = (ViewFile *) arg;
+    index_lines(vf);
+
+    pthread_mutex_lock(&(vf->idx_mutex));
+    vf->idx_busy = FALSE;
+    pthread_mutex_unlock(&(vf->idx_mutex));
+
+    pthread_exit(NULL);
+}
+
+
+/*
+** Scan the mapped bytes not yet indexed and add the start of each new line.
+** Offsets are added in batches to keep the lock short for the display.
+*/
+
+void index_lines(ViewFile *vf)
+{
+    int i;
+    long batch[IDX_BATCH];
+    char *p, *end;
+
+    p = vf->map + vf->idx_len;
+    end = vf->map + vf->map_len;
+    i = 0;
+
+    /* First line */
+    if (vf->line_cnt == 0 && vf->map_len > 0)
+    	batch[i++] = 0;
+
+    while(p < end && ! vf->stop)
+    {
+	if ((p = memchr(p, '\n', end - p)) == NULL)
+	    break;
+
+	p++;
+	batch[i++] = (long) (p - vf->map);
+
+	if (i == IDX_BATCH)
+	{
+	    pthread_mutex_lock(&(vf->idx_mutex));
+
+	    if (vf->line_cnt + i > vf->line_max)
+	    {
+		vf->line_max = (vf->line_cnt + i) * 2;
+		vf->line_off = (long *) realloc(vf->line_off, vf->line_max * sizeof(long));
+	    }
+
+	    memcpy(vf->line_off + vf->line_cnt, batch, i * sizeof(long));
+	    vf->line_cnt += i;
+	    vf->idx_len = (size_t) (p - vf->map);
+	    pthread_mutex_unlock(&(vf->idx_mutex));
+	    i = 0;
+	}
+    }
+
+    /* Remainder (a last line with no newline is indexed but not consumed) */
+    pthread_mutex_lock(&(vf->idx_mutex));
+
+    if (i > 0)
+    {
+	if (vf->line_cnt + i > vf->line_max)
+	{
+	    vf->line_max = (vf->line_cnt + i) * 2;
+	    vf->line_off = (long *) realloc(vf->line_off, vf->line_max * sizeof(long));
+	}
+
+	memcpy(vf->line_off + vf->line_cnt, batch, i * sizeof(long));
+	vf->line_cnt += i;
+    }
+
+    if (vf->line_cnt > 0)
+	vf->idx_len = (size_t) vf->line_off[vf->line_cnt - 1];
+
+    pthread_mutex_unlock(&(vf->idx_mutex));
+
+    return;
+}
+
+
+/* Number of lines for display - a trailing empty line is not shown */
+
+long disp_line_cnt(ViewFile *vf)
+{
+    long n;
+
+    n = vf->line_cnt;
+
+    if (n > 0 && (size_t) vf->line_off[n - 1] >= vf->map_len)
+    	n--;
+
+    return n;
+}
+
+
+/* Binary search for the line containing an offset */
+
+long offset_line(ViewFile *vf, size_t off)
+{
+    long lo, hi, mid;
+
+    lo = 0;
+    hi = vf->line_cnt - 1;
+
+    while(lo < hi)
+    {
+	mid = (lo + hi + 1) / 2;
+
+	if ((size_t) vf->line_off[mid] <= off)
+	    lo = mid;
+	else
+	    hi = mid - 1;
+    }
+
+    return lo;
+}
+
+
+/* Show the line count and any indexing progress */
+
+void set_view_status(ViewFile *vf)
+{
+    char s[80];
+
+    if (vf->idx_busy)
+	sprintf(s, "Indexing... %ld lines", disp_line_cnt(vf));
+    else
+	sprintf(s, "%ld lines", disp_line_cnt(vf));
+
+    gtk_label_set_text (GTK_LABEL (vf->status_lbl), s);
+
+    return;
+}
+
+
+/* Periodically show the lines indexed so far until the index thread is finished */
+
+gboolean index_progress(gpointer user_data)
+{
+    int done;
+    ViewFile *vf;
+
+    vf = (ViewFile *) user_data;
+
+    pthread_mutex_lock(&(vf->idx_mutex));
+    done = ! vf->idx_busy;
+    gtk_adjustment_set_upper (vf->adj, (double) disp_line_cnt(vf));
+    pthread_mutex_unlock(&(vf->idx_mutex));
+
+    if (done)
+    {
+	pthread_join(vf->idx_tid, NULL);
+	vf->idx_tmr = 0;
+    }
+
+    set_view_status(vf);
+    gtk_widget_queue_draw (vf->draw_area);
+
+    return (done ? FALSE : TRUE);
+}
+
+
+/* Tail follow - map and index any data added to the file and scroll to the end */
+
+gboolean follow_tail(gpointer user_data)
+{
+    ViewFile *vf;
+    struct stat fileStat, fdStat;
+    double pg;
+
+    vf = (ViewFile *) user_data;
+
+    if (vf->idx_busy || vf->fd < 0)
+    	return TRUE;
+
+    if (fstat(vf->fd, &fdStat) < 0)
+    	return TRUE;
+
+    /* Log rotated (replaced by a new file) - start again on the new file */
+    if (stat(vf->fn, &fileStat) == 0 && fileStat.st_ino != fdStat.st_ino)
+    {
+	unmap_view_file(vf);
+	close(vf->fd);
+	vf->fd = -1;
+	vf->map_len = 0;
+	vf->line_cnt = 0;
+	vf->idx_len = 0;
+	vf->match_line = -1;
+	fdStat.st_size = -1;
+    }
+
+    if ((size_t) fdStat.st_size == vf->map_len)
+    	return TRUE;
+
+    /* Truncated - start again */
+    if (fdStat.st_size >= 0 && (size_t) fdStat.st_size < vf->map_len)
+    {
+	vf->line_cnt = 0;
+	vf->idx_len = 0;
+	vf->match_line = -1;
+    }
+
+    unmap_view_file(vf);
+
+    if (map_view_file(vf) == FALSE)
+    	return TRUE;
+
+    index_lines(vf);
+
+    gtk_adjustment_set_upper (vf->adj, (double) disp_line_cnt(vf));
+    pg = gtk_adjustment_get_page_size (vf->adj);
+    gtk_adjustment_set_value (vf->adj, (double) disp_line_cnt(vf) - pg);
+    set_view_status(vf);
+    gtk_widget_queue_draw (vf->draw_area);
 
     return TRUE;
 }
@@ -104,20 +545,14 @@ int view_file_init(char *fn)
 GtkWidget* view_file_ui(char *fn)
 {  
     GtkWidget *view_file_window;  
-    GtkWidget *scrollwin;
-    GtkWidget *mbox, *bbox, *lbox;  
+    GtkWidget *vscroll;
+    GtkWidget *mbox, *bbox, *lbox, *tbox, *sbox;  
     GtkWidget *label_t, *label_f;  
-    GtkWidget *close_btn;  
-    GtkWidget *txt_view;  
-    GtkTextBuffer *txt_buffer;  
-    GtkTextIter iter;
+    GtkWidget *close_btn, *find_btn;  
     GtkWidget *menu_bar;
     PangoFontDescription *font_desc;
-    char buffer[500];
-    int rc;
     int close_hndlr_id;
 
-printf("%s view_file_ui 1\n", debug_hdr); fflush(stdout);
     /* Set up the UI window */
     view_file_window = gtk_window_new(GTK_WINDOW_TOPLEVEL);  
     gtk_window_set_title(GTK_WINDOW(view_file_window), VIEW_FILE_UI);
@@ -140,39 +575,38 @@ printf("%s view_file_ui 1\n", debug_hdr); fflush(stdout);
     gtk_widget_override_color(label_f, GTK_STATE_FLAG_NORMAL, &DARK_BLUE);
     gtk_widget_override_font (GTK_WIDGET (label_f), font_desc);
 
+    vf->status_lbl = gtk_label_new("");
+    gtk_widget_override_font (GTK_WIDGET (vf->status_lbl), font_desc);
+
     pango_font_description_free (font_desc);
 
     lbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
     gtk_box_pack_start (GTK_BOX (lbox), label_t, FALSE, FALSE, 0);
     gtk_box_pack_start (GTK_BOX (lbox), label_f, FALSE, FALSE, 0);
-    
-    /* Scrolled window for TextView */
-    scrollwin = gtk_scrolled_window_new(NULL, NULL);
-    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW (scrollwin),
-    				   GTK_POLICY_AUTOMATIC,
-    				   GTK_POLICY_AUTOMATIC);
-
-    /* Text area for file contents */
-    txt_view = gtk_text_view_new();
-    gtk_container_add(GTK_CONTAINER(scrollwin), txt_view);
-    txt_buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (txt_view));
-    gtk_widget_set_size_request (scrollwin, 500, 400);
-    gtk_text_buffer_set_text (txt_buffer, "", -1);
-    gtk_text_view_set_editable (GTK_TEXT_VIEW (txt_view), FALSE);
-
-    /* Populate the text area */
-    rc = TRUE;
-
-    while(rc != EOF)
-    {
-	/* Read the camera information file */
-	rc = read_file(fd, buffer, sizeof(buffer));
+    gtk_box_pack_end (GTK_BOX (lbox), vf->status_lbl, FALSE, FALSE, 0);
+
+    /* Search and tail follow */
+    vf->search_ent = gtk_search_entry_new();
+    find_btn = gtk_button_new_with_label("Find");
+    vf->follow_chk = gtk_check_button_new_with_label("Follow");
+
+    sbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    gtk_box_pack_start (GTK_BOX (sbox), vf->search_ent, TRUE, TRUE, 0);
+    gtk_box_pack_start (GTK_BOX (sbox), find_btn, FALSE, FALSE, 0);
+    gtk_box_pack_end (GTK_BOX (sbox), vf->follow_chk, FALSE, FALSE, 0);
+
+    /* Drawing area for the visible lines and a scrollbar over the line index */
+    vf->adj = gtk_adjustment_new (0, 0, 0, 1, 10, 10);
+    vscroll = gtk_scrollbar_new(GTK_ORIENTATION_VERTICAL, vf->adj);
+
+    vf->draw_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request (vf->draw_area, 500, 400);
+    gtk_widget_add_events (vf->draw_area, GDK_SCROLL_MASK);
+
+    tbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+    gtk_box_pack_start (GTK_BOX (tbox), vf->draw_area, TRUE, TRUE, 0);
+    gtk_box_pack_start (GTK_BOX (tbox), vscroll, FALSE, FALSE, 0);
 
-	gtk_text_buffer_get_end_iter (txt_buffer, &iter);
-	gtk_text_buffer_insert (txt_buffer, &iter, buffer, -1);
-	gtk_text_iter_forward_to_end (&iter);
-    }
-    
     /* Close button */
     close_btn = gtk_button_new_with_label("  Close  ");
     g_signal_connect_swapped(close_btn, "clicked", G_CALLBACK(OnViewFileClose), view_file_window);
@@ -186,11 +620,24 @@ printf("%s view_file_ui 1\n", debug_hdr); fflush(stdout);
     /* Combine everything onto the window */
     gtk_box_pack_start (GTK_BOX (mbox), menu_bar, FALSE, FALSE, 2);
     gtk_box_pack_start (GTK_BOX (mbox), lbox, FALSE, FALSE, 0);
-    gtk_box_pack_start (GTK_BOX (mbox), scrollwin, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (mbox), sbox, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (mbox), tbox, TRUE, TRUE, 0);
     gtk_box_pack_start (GTK_BOX (mbox), bbox, FALSE, FALSE, 0);
 
     gtk_container_add(GTK_CONTAINER(view_file_window), mbox);  
 
+    /* Callbacks */
+    g_signal_connect(vf->draw_area, "draw", G_CALLBACK(OnViewDraw), vf);
+    g_signal_connect(vf->draw_area, "scroll-event", G_CALLBACK(OnViewScroll), vf);
+    g_signal_connect(vf->adj, "value-changed", G_CALLBACK(OnViewScrollChg), vf);
+    g_signal_connect(vf->search_ent, "activate", G_CALLBACK(OnViewFind), vf);
+    g_signal_connect(find_btn, "clicked", G_CALLBACK(OnViewFind), vf);
+    g_signal_connect(vf->follow_chk, "toggled", G_CALLBACK(OnViewFollow), vf);
+
+    /* Archives do not change */
+    if (vf->fd < 0)
+	gtk_widget_set_sensitive (vf->follow_chk, FALSE);
+
     /* Exit when window closed */
     close_hndlr_id = g_signal_connect(view_file_window, "destroy", G_CALLBACK(OnViewFileClose), view_file_window);  
     g_object_set_data (G_OBJECT (view_file_window), "close_hndlr_id", GINT_TO_POINTER (close_hndlr_id));
@@ -200,7 +647,7 @@ printf("%s view_file_ui 1\n", debug_hdr); fflush(stdout);
 
 
 /*
-** Menu function for camera information window
+** Menu function for file view window
 **
 **  File
 **   - Close
@@ -249,6 +696,238 @@ GtkWidget* view_file_ui_menu(GtkWidget *window)
 }
 
 
+/* Callback - Draw the visible lines directly from the mapping */
+
+gboolean OnViewDraw(GtkWidget *widget, cairo_t *cr, gpointer user_data)
+{
+    ViewFile *vf;
+    GtkAllocation alloc;
+    cairo_font_extents_t fe;
+    long i, first, last, n;
+    size_t len;
+    int j, k, c_len;
+    double y;
+    char *p;
+    char line[MAX_LINE_DISP + 1];
+
+    vf = (ViewFile *) user_data;
+    gtk_widget_get_allocation(widget, &alloc);
+
+    /* Background */
+    cairo_set_source_rgb (cr, WHITE.red, WHITE.green, WHITE.blue);
+    cairo_paint (cr);
+
+    cairo_select_font_face (cr, "Monospace", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size (cr, 11.0);
+    cairo_font_extents (cr, &fe);
+    vf->line_ht = fe.height;
+
+    /* Page size follows the window size */
+    n = (long) (alloc.height / vf->line_ht);
+
+    if ((long) gtk_adjustment_get_page_size (vf->adj) != n)
+    {
+	gtk_adjustment_set_page_size (vf->adj, (double) n);
+	gtk_adjustment_set_page_increment (vf->adj, (double) n);
+    }
+
+    pthread_mutex_lock(&(vf->idx_mutex));
+
+    first = (long) gtk_adjustment_get_value (vf->adj);
+    last = disp_line_cnt(vf);
+
+    if (first + n + 1 < last)
+    	last = first + n + 1;
+
+    for(i = first, y = fe.ascent; i < last; i++, y += vf->line_ht)
+    {
+	/* Line length excluding the newline */
+	p = vf->map + vf->line_off[i];
+
+	if (i + 1 < vf->line_cnt)
+	    len = (size_t) (vf->line_off[i + 1] - vf->line_off[i] - 1);
+	else
+	    len = vf->map_len - (size_t) vf->line_off[i];
+
+	/* Copy for display, expanding tabs and dropping non-printables. Cairo needs valid
+	   UTF-8, so only whole characters are copied and invalid bytes show as '?' */
+	for(j = 0, k = 0; j < (int) len && k < MAX_LINE_DISP; j++)
+	{
+	    if (p[j] == '\t')
+	    {
+		do
+		    line[k++] = ' ';
+		while(k % 8 != 0 && k < MAX_LINE_DISP);
+	    }
+	    else if ((unsigned char) p[j] >= 0x80)
+	    {
+		c_len = g_utf8_skip[(unsigned char) p[j]];
+
+		if (c_len > (int) len - j || g_utf8_get_char_validated(p + j, c_len) > 0x10ffff)
+		{
+		    line[k++] = '?';
+		}
+		else
+		{
+		    if (k + c_len > MAX_LINE_DISP)
+			break;
+
+		    memcpy(line + k, p + j, c_len);
+		    k += c_len;
+		    j += c_len - 1;
+		}
+	    }
+	    else if ((unsigned char) p[j] >= ' ' && p[j] != 0x7f)
+	    {
+		line[k++] = p[j];
+	    }
+	}
+
+	line[k] = '\0';
+
+	/* Highlight a search match */
+	if (i == vf->match_line)
+	{
+	    cairo_set_source_rgb (cr, MID_YELLOW.red, MID_YELLOW.green, MID_YELLOW.blue);
+	    cairo_rectangle (cr, 0, y - fe.ascent, alloc.width, vf->line_ht);
+	    cairo_fill (cr);
+	}
+
+	cairo_set_source_rgb (cr, BLACK.red, BLACK.green, BLACK.blue);
+	cairo_move_to (cr, 3, y);
+	cairo_show_text (cr, line);
+    }
+
+    pthread_mutex_unlock(&(vf->idx_mutex));
+
+    return FALSE;
+}
+
+
+/* Callback - Mouse wheel scroll */
+
+gboolean OnViewScroll(GtkWidget *widget, GdkEventScroll *ev, gpointer user_data)
+{
+    ViewFile *vf;
+    double v;
+
+    vf = (ViewFile *) user_data;
+    v = gtk_adjustment_get_value (vf->adj);
+
+    if (ev->direction == GDK_SCROLL_UP)
+    	v -= 3;
+    else if (ev->direction == GDK_SCROLL_DOWN)
+    	v += 3;
+    else if (ev->direction == GDK_SCROLL_SMOOTH)
+    	v += ev->delta_y * 3;
+
+    gtk_adjustment_set_value (vf->adj, v);
+
+    return TRUE;
+}
+
+
+/* Callback - Scrollbar moved */
+
+void OnViewScrollChg(GtkAdjustment *adj, gpointer user_data)
+{
+    ViewFile *vf;
+
+    vf = (ViewFile *) user_data;
+    gtk_widget_queue_draw (vf->draw_area);
+
+    return;
+}
+
+
+/* Callback - Search the mapping for the next match after the last one (wraps to the start) */
+
+void OnViewFind(GtkWidget *widget, gpointer user_data)
+{
+    ViewFile *vf;
+    const gchar *txt;
+    char *p;
+    size_t len, start;
+    double pg;
+
+    vf = (ViewFile *) user_data;
+    txt = gtk_entry_get_text (GTK_ENTRY (vf->search_ent));
+    len = strlen(txt);
+
+    if (len == 0 || vf->map == NULL)
+    	return;
+
+    pthread_mutex_lock(&(vf->idx_mutex));
+
+    /* Start after the current match, or at the top of the window */
+    if (vf->match_line >= 0)
+	start = vf->match_off + 1;
+    else if (vf->line_cnt > 0)
+	start = (size_t) vf->line_off[(long) gtk_adjustment_get_value (vf->adj)];
+    else
+	start = 0;
+
+    if (start >= vf->map_len)
+    	start = 0;
+
+    p = memmem(vf->map + start, vf->map_len - start, txt, len);
+
+    if (p == NULL && start > 0)
+	p = memmem(vf->map, start + len - 1 < vf->map_len ? start + len - 1 : vf->map_len, txt, len);
+
+    /* Not found, or not yet indexed */
+    if (p == NULL || ((size_t) (p - vf->map) >= vf->idx_len && vf->idx_busy))
+    {
+	vf->match_line = -1;
+	pthread_mutex_unlock(&(vf->idx_mutex));
+	gtk_label_set_text (GTK_LABEL (vf->status_lbl), (p == NULL) ? "Not found" : "Still indexing...");
+	gtk_widget_queue_draw (vf->draw_area);
+	return;
+    }
+
+    vf->match_off = (size_t) (p - vf->map);
+    vf->match_line = offset_line(vf, vf->match_off);
+    pthread_mutex_unlock(&(vf->idx_mutex));
+
+    /* Bring the line into view, about a third of the way down */
+    pg = gtk_adjustment_get_page_size (vf->adj);
+
+    if (vf->match_line < (long) gtk_adjustment_get_value (vf->adj)
+    	|| vf->match_line >= (long) (gtk_adjustment_get_value (vf->adj) + pg))
+	gtk_adjustment_set_value (vf->adj, (double) vf->match_line - pg / 3);
+
+    set_view_status(vf);
+    gtk_widget_queue_draw (vf->draw_area);
+
+    return;
+}
+
+
+/* Callback - Turn tail follow on or off */
+
+void OnViewFollow(GtkToggleButton *chk, gpointer user_data)
+{
+    ViewFile *vf;
+
+    vf = (ViewFile *) user_data;
+
+    if (gtk_toggle_button_get_active (chk))
+    {
+	if (vf->follow_tmr == 0)
+	    vf->follow_tmr = g_timeout_add_seconds(1, follow_tail, vf);
+
+	follow_tail(vf);
+    }
+    else if (vf->follow_tmr > 0)
+    {
+	g_source_remove (vf->follow_tmr);
+	vf->follow_tmr = 0;
+    }
+
+    return;
+}
+
+
 // Callback for window close
 // Destroy the window and de-register the window 
 
@@ -261,5 +940,31 @@ void OnViewFileClose(GtkWidget *window, gpointer user_data)
     deregister_window(window);
     gtk_window_close(GTK_WINDOW(window));
 
+    /* Stop indexing and release the file */
+    if (vf != NULL)
+    {
+	vf->stop = TRUE;
+
+	if (vf->idx_tmr > 0)
+	{
+	    g_source_remove (vf->idx_tmr);
+	    pthread_join(vf->idx_tid, NULL);
+	}
+
+	if (vf->follow_tmr > 0)
+	    g_source_remove (vf->follow_tmr);
+
+	unmap_view_file(vf);
+
+	if (vf->fd >= 0)
+	    close(vf->fd);
+
+	pthread_mutex_destroy(&(vf->idx_mutex));
+	free(vf->line_off);
+	free(vf->fn);
+	free(vf);
+	vf = NULL;
+    }
+
     return;
 }